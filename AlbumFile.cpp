@@ -0,0 +1,333 @@
+/**
+ * @file    AlbumFile.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Versioned binary Album files, which are memory mapped and used in place
+ * without a parse step.
+ */
+
+#include <cstring>
+#include <limits>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "AlbumFile.h"
+#include "Utilities.h"
+
+
+/**
+ * @section binary Album file writing.
+ *
+ */
+
+static const char magic[4]{'B', 'A', 'L', 'B'};
+
+template<typename T>
+static void appendRaw(Writer & out, const T & value)
+{
+    out.append(std::string_view{reinterpret_cast<const char *>(&value), sizeof(value)});
+}
+
+/**
+ * @brief Format an album in the binary Album file layout.
+ * 
+ * @param out writer to format into.
+ * @param album to format.
+ * @return true if the album was formatted, false if it is too large.
+ */
+bool formatAlbumFile(Writer & out, const Album & album)
+{
+    AlbumHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = albumFileVersion;
+    header.sides = album.size();
+    header.seconds = album.getValue();
+    header.strings = album.getTitle().size();
+    size_t tracks{};
+    size_t longest{};
+    for (const auto & side : album)
+    {
+        tracks += side.size();
+        longest = std::max(longest, side.getValue());
+        header.strings += side.getTitle().size();
+        for (const auto & track : side)
+            header.strings += track.getTitle().size();
+    }
+    header.tracks = tracks;
+
+    const size_t limit{std::numeric_limits<uint32_t>::max()};
+    if ((album.size() > limit) || (tracks > limit) || (longest > limit) || (header.strings > limit))
+        return false;
+
+    appendRaw(out, header);
+
+    uint32_t first{};
+    for (const auto & side : album)
+    {
+        const SideEntry entry{first, static_cast<uint32_t>(side.size()), static_cast<uint32_t>(side.getValue()), 0};
+        appendRaw(out, entry);
+        first += entry.count;
+    }
+
+    for (const auto & side : album)
+        for (const auto & track : side)
+            appendRaw(out, static_cast<uint32_t>(track.getValue()));
+
+    uint32_t offset{};
+    auto appendTitle{[&out, &offset](std::string_view title)
+    {
+        appendRaw(out, TitleEntry{offset, static_cast<uint32_t>(title.size())});
+        offset += title.size();
+    }};
+
+    appendTitle(album.getTitle());
+    for (const auto & side : album)
+        appendTitle(side.getTitle());
+    for (const auto & side : album)
+        for (const auto & track : side)
+            appendTitle(track.getTitle());
+
+    out.append(album.getTitle());
+    for (const auto & side : album)
+        out.append(side.getTitle());
+    for (const auto & side : album)
+        for (const auto & track : side)
+            out.append(track.getTitle());
+
+    return true;
+}
+
+/**
+ * @brief Write an album to a binary Album file.
+ * 
+ * @param album to write.
+ * @param fileName of the file to write.
+ * @return int 0 if successful, 1 otherwise.
+ */
+int writeAlbumFile(const Album & album, const std::string & fileName)
+{
+    Writer out{};
+    if (!formatAlbumFile(out, album))
+        return 1;
+
+    const int fd{open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+    if (fd == -1)
+        return 1;
+
+    const bool written{out.write(fd)};
+
+    return (close(fd) == 0) && written ? 0 : 1;
+}
+
+/**
+ * @brief Read a CSV ('|') album, as written by Balancer, reading the whole
+ * file in one go and parsing it in a single pass. The sides and tracks are
+ * held by the given allocator, which must outlive the album.
+ * 
+ * @param fileName of the file to read.
+ * @param allocator for the sides and tracks, the default resource if none.
+ * @return Album the album, empty if the file can't be read.
+ */
+Album readAlbum(const std::string & fileName, const Album::allocator_type & allocator)
+{
+    Album album{allocator};
+
+    std::ifstream input{fileName, std::ios::binary | std::ios::ate};
+    if (!input)
+        return album;
+
+    const auto size{input.tellg()};
+    if (size < 0)
+        return album;
+
+    std::string buffer(static_cast<size_t>(size), '\0');
+    input.seekg(0);
+    if (input.read(buffer.data(), buffer.size()))
+        album.parse(buffer);
+
+    return album;
+}
+
+
+/**
+ * @section Define AlbumFile class.
+ *
+ */
+
+/**
+ * @brief Memory map the file and locate the tables within it. Nothing is
+ * parsed, only the header is checked against the size and the side and
+ * title entries against the tables they refer to.
+ * 
+ * @return int 0 if successful, 1 otherwise.
+ */
+int AlbumFile::map(void)
+{
+    mapping.reset();
+    header = nullptr;
+
+    const int fd{open(fileName.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fd == -1)
+        return 1;
+
+    struct stat status;
+    if ((fstat(fd, &status) == -1) || (static_cast<size_t>(status.st_size) < sizeof(AlbumHeader)))
+    {
+        close(fd);
+        return 1;
+    }
+
+    const size_t length{static_cast<size_t>(status.st_size)};
+    void * address{mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0)};
+    close(fd);
+    if (address == MAP_FAILED)
+        return 1;
+
+    mapping = std::make_shared<const Mapping>(address, length);
+
+    const char * base{static_cast<const char *>(address)};
+    header = reinterpret_cast<const AlbumHeader *>(base);
+    if ((std::memcmp(header->magic, magic, sizeof(magic)) != 0) || (header->version != albumFileVersion))
+    {
+        header = nullptr;
+        return 1;
+    }
+
+    // Check each table fits in what is left of the file before taking it,
+    // so a corrupt header can't wrap the total size.
+    const size_t sides{header->sides};
+    const size_t tracks{header->tracks};
+    size_t remaining{length - sizeof(AlbumHeader)};
+    auto take{[&remaining](size_t count, size_t size)
+    {
+        if (count > remaining / size)
+            return false;
+
+        remaining -= count * size;
+
+        return true;
+    }};
+    if (!take(sides, sizeof(SideEntry)) || !take(tracks, sizeof(uint32_t)) ||
+        !take(1 + sides + tracks, sizeof(TitleEntry)) || (remaining != header->strings))
+    {
+        header = nullptr;
+        return 1;
+    }
+
+    const char * next{base + sizeof(AlbumHeader)};
+    sideEntries = {reinterpret_cast<const SideEntry *>(next), sides};
+    next += sides * sizeof(SideEntry);
+    durations = {reinterpret_cast<const uint32_t *>(next), tracks};
+    next += tracks * sizeof(uint32_t);
+    titles = {reinterpret_cast<const TitleEntry *>(next), 1 + sides + tracks};
+    next += titles.size() * sizeof(TitleEntry);
+    strings = {next, header->strings};
+
+    if (!validate())
+    {
+        header = nullptr;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Check the side entries cover the tracks in order and every title
+ * lies within the title text, so the accessors are safe once mapped.
+ */
+bool AlbumFile::validate(void) const
+{
+    size_t first{};
+    for (const auto & side : sideEntries)
+    {
+        if (side.first != first)
+            return false;
+        first += side.count;
+    }
+
+    if (first != durations.size())
+        return false;
+
+    for (const auto & entry : titles)
+        if (size_t{entry.offset} + entry.length > strings.size())
+            return false;
+
+    return true;
+}
+
+/**
+ * @brief Load the mapped file into an Album, with the titles copied into the
+ * album's title pool.
+ * 
+ * @return Album the loaded album.
+ */
+Album AlbumFile::load(void) const
+{
+    Album album{};
+    if (!isOpen())
+        return album;
+
+    album.setTitle(getTitle());
+    Titles & pool{album.getTitles()};
+    album.reserve(size());
+    for (size_t i = 0; i < size(); ++i)
+    {
+        const auto & entry{sideEntries[i]};
+        Side side{};
+        side.setTitle(getSideTitle(i));
+        side.reserve(entry.count);
+        for (size_t track = entry.first; track < entry.first + entry.count; ++track)
+            side.push(Track::pooled(pool.store(getTrackTitle(track)), durations[track]));
+        album.push(std::move(side));
+    }
+
+    return album;
+}
+
+/**
+ * @brief Format the album as Balancer CSV, with plain durations, as read by
+ * Album::parse().
+ * 
+ * @param out writer to format into.
+ */
+void AlbumFile::formatCsv(Writer & out) const
+{
+    if (!isOpen())
+        return;
+
+    for (size_t i = 0; i < size(); ++i)
+    {
+        const auto & entry{sideEntries[i]};
+        out.append("Side").append(oSep).appendNumber(entry.seconds).append(oSep);
+        out.append('"').append(getSideTitle(i)).append(", ").appendNumber(entry.count).append(" tracks\"\n");
+        for (size_t track = entry.first; track < entry.first + entry.count; ++track)
+        {
+            out.append("Track").append(oSep).appendNumber(durations[track]).append(oSep);
+            out.append('"').append(getTrackTitle(track)).append("\"\n");
+        }
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file    AlbumFile.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Versioned binary Album files, which are memory mapped and used in place
+ * without a parse step.
+ *
+ * The layout, in native byte order, is:
+ *   AlbumHeader
+ *   SideEntry side[sides]          Tracks, duration and title of each side.
+ *   uint32_t duration[tracks]      Track durations in seconds.
+ *   TitleEntry title[1+sides+tracks]  Album, side and track titles.
+ *   char strings[]                 The title text.
+ */
+
+#if !defined _ALBUMFILE_H_INCLUDED_
+#define _ALBUMFILE_H_INCLUDED_
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "Side.h"
+#include "TextFile.h"
+#include "Writer.h"
+
+
+/**
+ * @section binary Album file layout.
+ *
+ */
+
+struct AlbumHeader
+{
+    char magic[4];      // "BALB".
+    uint32_t version;   // albumFileVersion.
+    uint32_t sides;     // Number of sides.
+    uint32_t tracks;    // Number of tracks on all sides.
+    uint64_t seconds;   // Album duration.
+    uint64_t strings;   // Size of the title text.
+};
+
+struct SideEntry
+{
+    uint32_t first;     // Index of the first track.
+    uint32_t count;     // Number of tracks.
+    uint32_t seconds;   // Side duration.
+    uint32_t reserved;
+};
+
+struct TitleEntry
+{
+    uint32_t offset;    // Start of the title in the title text.
+    uint32_t length;
+};
+
+const uint32_t albumFileVersion{1};
+
+extern bool formatAlbumFile(Writer & out, const Album & album);
+extern int writeAlbumFile(const Album & album, const std::string & fileName);
+extern Album readAlbum(const std::string & fileName, const Album::allocator_type & allocator = {});
+
+
+/**
+ * @section Define AlbumFile class.
+ *
+ * A read only view of a memory mapped binary Album file.
+ */
+
+class AlbumFile
+{
+public:
+    AlbumFile(const std::string & file) : fileName{file}, header{}, sideEntries{}, durations{}, titles{}, strings{} {}
+
+    int map(void);
+    bool isOpen(void) const { return header != nullptr; }
+
+    std::string_view getTitle(void) const { return title(0); }
+    size_t getValue(void) const { return header->seconds; }
+    size_t size(void) const { return sideEntries.size(); }
+    size_t tracks(void) const { return durations.size(); }
+
+    const SideEntry & getSide(size_t index) const { return sideEntries[index]; }
+    std::string_view getSideTitle(size_t index) const { return title(1 + index); }
+    std::span<const uint32_t> getDurations(void) const { return durations; }
+    std::string_view getTrackTitle(size_t index) const { return title(1 + size() + index); }
+
+    Album load(void) const;
+    void formatCsv(Writer & out) const;
+
+private:
+    std::string fileName;
+    std::shared_ptr<const Mapping> mapping;
+
+    const AlbumHeader * header;
+    std::span<const SideEntry> sideEntries;
+    std::span<const uint32_t> durations;
+    std::span<const TitleEntry> titles;
+    std::string_view strings;
+
+    std::string_view title(size_t index) const { return {strings.data() + titles[index].offset, titles[index].length}; }
+    bool validate(void) const;
+
+};
+
+
+#endif //!defined _ALBUMFILE_H_INCLUDED_
@@ -0,0 +1,392 @@
+/**
+ * @file    Engine.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * In-process balancing engine, allowing tracks to be balanced without
+ * running the Balancer utility.
+ */
+
+#include <algorithm>
+#include <numeric>
+
+#include "Engine.h"
+
+
+/**
+ * @section Support code.
+ *
+ */
+
+static size_t totalDuration(const std::vector<Track> & tracks)
+{
+    auto add{[](size_t total, const Track & track) { return total + track.getValue(); }};
+
+    return std::accumulate(tracks.begin(), tracks.end(), size_t{}, add);
+}
+
+static size_t longestTrack(const std::vector<Track> & tracks)
+{
+    size_t longest{};
+    for (const auto & track : tracks)
+        longest = std::max(longest, track.getValue());
+
+    return longest;
+}
+
+/**
+ * @brief Create the requested number of empty, titled sides.
+ *
+ * @param count of sides required.
+ * @return std::vector<Side> the empty sides.
+ */
+static std::vector<Side> createSides(size_t count)
+{
+    std::vector<Side> sides(count);
+    for (size_t i = 0; i < count; ++i)
+        sides[i].setTitle("Side " + std::to_string(i+1));
+
+    return sides;
+}
+
+static Album createAlbum(std::vector<Side> && sides)
+{
+    Album album{};
+    album.reserve(sides.size());
+    for (auto & side : sides)
+        album.push(std::move(side));
+
+    return album;
+}
+
+/**
+ * @brief Fill the sides in track order, moving on to the next side when the
+ * limit would be exceeded. The last side takes any remaining tracks and a
+ * side is never left empty while there are tracks to place.
+ *
+ * @param tracks to place.
+ * @param sides to fill.
+ * @param limit the maximum side duration.
+ * @return size_t the number of sides used.
+ */
+static size_t fill(const std::vector<Track> & tracks, std::vector<Side> & sides, size_t limit)
+{
+    const size_t count{tracks.size()};
+    size_t current{};
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto & track{tracks[i]};
+        const auto & side{sides[current]};
+        if ((side.size()) && (current+1 < sides.size()))
+        {
+            const bool full{side.getValue() + track.getValue() > limit};
+            const bool needed{count - i <= sides.size() - (current+1)};
+            if (full || needed)
+                ++current;
+        }
+
+        sides[current].push(track);
+    }
+
+    return current+1;
+}
+
+/**
+ * @brief Determine if the tracks can be split, in order, across the given
+ * number of sides without any side exceeding the limit.
+ */
+static bool splits(const std::vector<Track> & tracks, size_t count, size_t limit)
+{
+    size_t used{1};
+    size_t seconds{};
+    for (const auto & track : tracks)
+    {
+        seconds += track.getValue();
+        if (seconds > limit)
+        {
+            seconds = track.getValue();
+            if (++used > count)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Count the sides needed to hold the tracks, in order, without any
+ * side exceeding the duration (unless a single track does).
+ */
+static size_t orderedSides(const std::vector<Track> & tracks, size_t duration)
+{
+    size_t count{1};
+    size_t seconds{};
+    for (const auto & track : tracks)
+    {
+        seconds += track.getValue();
+        if ((seconds > duration) && (seconds != track.getValue()))
+        {
+            seconds = track.getValue();
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Brute force search state. The tracks are placed longest first, as
+ * this finds a solution, or proves there is none, far sooner.
+ */
+struct Search
+{
+    std::vector<size_t> durations;  // Track durations, longest first.
+    std::vector<size_t> remaining;  // Total duration of durations[i] onwards.
+    std::vector<size_t> loads;      // Current duration of each side.
+    std::vector<size_t> placed;     // Side each track is placed on.
+    size_t limit;                   // Maximum side duration.
+};
+
+/**
+ * @brief Recursively place the tracks from index onwards on the sides without
+ * exceeding the limit, trying each side in turn for each track.
+ *
+ * @param search state.
+ * @param index of the next track to place.
+ * @return true if all the tracks were placed, false otherwise.
+ */
+static bool place(Search & search, size_t index)
+{
+    const size_t count{search.durations.size()};
+    if (index == count)
+        return true;
+
+    // Give up if the space that can still be used can't hold the remaining tracks.
+    auto & loads{search.loads};
+    const size_t limit{search.limit};
+    const size_t shortest{search.durations.back()};
+    size_t space{};
+    for (const auto load : loads)
+        if (load + shortest <= limit)
+            space += limit - load;
+
+    if (space < search.remaining[index])
+        return false;
+
+    const size_t duration{search.durations[index]};
+    for (size_t i = 0; i < loads.size(); ++i)
+    {
+        if (loads[i] + duration > limit)
+            continue;
+
+        // A side with the same duration as one already tried gives the same result.
+        if (std::find(loads.begin(), loads.begin()+i, loads[i]) != loads.begin()+i)
+            continue;
+
+        loads[i] += duration;
+        search.placed[index] = i;
+        if (place(search, index+1))
+            return true;
+        loads[i] -= duration;
+    }
+
+    return false;
+}
+
+/**
+ * @section balancing engine.
+ *
+ */
+
+/**
+ * @brief Determine the number of sides required by the configuration. For a
+ * duration, this is the number of sides needed to hold the tracks in order,
+ * unless the tracks can be reordered.
+ *
+ * @param tracks to be balanced.
+ * @param config the balancing configuration.
+ * @return size_t the number of sides, at least 1.
+ */
+size_t sideCount(const std::vector<Track> & tracks, const Config & config)
+{
+    size_t count{config.boxes};
+    if (!count && config.duration)
+    {
+        if (config.shuffle || config.force)
+            count = (totalDuration(tracks) + config.duration - 1) / config.duration;
+        else
+            count = orderedSides(tracks, config.duration);
+    }
+
+    if (config.even && (count % 2))
+        ++count;
+
+    return std::max(count, size_t{1});
+}
+
+/**
+ * @brief Split the tracks, in order, across the sides. By default each side
+ * is filled up to the average side duration. The ideal split uses the
+ * smallest longest side achievable without reordering.
+ *
+ * @param tracks to be balanced.
+ * @param sides the number of sides required, at least 1 is used.
+ * @param ideal true if the smallest longest side is required.
+ * @return Album the balanced sides.
+ */
+Album splitTracks(const std::vector<Track> & tracks, size_t sides, bool ideal)
+{
+    sides = std::max(sides, size_t{1});
+    const size_t total{totalDuration(tracks)};
+    size_t limit{(total + sides - 1) / sides};
+
+    if (ideal)
+    {
+        size_t low{std::max(limit, longestTrack(tracks))};
+        size_t high{std::max(low, total)};
+        while (low < high)
+        {
+            const size_t mid{low + (high - low) / 2};
+            if (splits(tracks, sides, mid))
+                high = mid;
+            else
+                low = mid + 1;
+        }
+        limit = low;
+    }
+
+    auto album{createSides(sides)};
+    fill(tracks, album, limit);
+
+    return createAlbum(std::move(album));
+}
+
+/**
+ * @brief Reorder the tracks to balance the sides, placing the longest
+ * remaining track on the shortest side each time.
+ *
+ * @param tracks to be balanced.
+ * @param sides the number of sides required, at least 1 is used.
+ * @return Album the balanced sides.
+ */
+Album shuffleTracks(const std::vector<Track> & tracks, size_t sides)
+{
+    sides = std::max(sides, size_t{1});
+    std::vector<size_t> order(tracks.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto longer{[&tracks](size_t a, size_t b) { return tracks[a].getValue() > tracks[b].getValue(); }};
+    std::stable_sort(order.begin(), order.end(), longer);
+
+    auto album{createSides(sides)};
+    auto shorter{[](const Side & a, const Side & b) { return a.getValue() < b.getValue(); }};
+    for (const auto index : order)
+        std::min_element(album.begin(), album.end(), shorter)->push(tracks[index]);
+
+    return createAlbum(std::move(album));
+}
+
+/**
+ * @brief Search all arrangements of the tracks for the smallest achievable
+ * longest side. Each side lists its tracks in their original order.
+ *
+ * @param tracks to be balanced.
+ * @param sides the number of sides required, at least 1 is used.
+ * @return Album the balanced sides.
+ */
+Album bruteForce(const std::vector<Track> & tracks, size_t sides)
+{
+    sides = std::max(sides, size_t{1});
+    const size_t count{tracks.size()};
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    auto longer{[&tracks](size_t a, size_t b) { return tracks[a].getValue() > tracks[b].getValue(); }};
+    std::stable_sort(order.begin(), order.end(), longer);
+
+    Search search{};
+    search.durations.reserve(count);
+    for (const auto index : order)
+        search.durations.push_back(tracks[index].getValue());
+    search.remaining.resize(count+1);
+    for (size_t i = count; i > 0; --i)
+        search.remaining[i-1] = search.remaining[i] + search.durations[i-1];
+    search.placed.resize(count);
+
+    // The shuffled sides give an achievable upper bound to search below.
+    const Album shuffled{shuffleTracks(tracks, sides)};
+    size_t high{};
+    for (const auto & side : shuffled)
+        high = std::max(high, side.getValue());
+
+    const size_t total{totalDuration(tracks)};
+    size_t low{std::max((total + sides - 1) / sides, longestTrack(tracks))};
+    std::vector<size_t> best{};
+    while (low < high)
+    {
+        search.limit = low + (high - low) / 2;
+        search.loads.assign(sides, 0);
+        if (place(search, 0))
+        {
+            high = search.limit;
+            best = search.placed;
+        }
+        else
+            low = search.limit + 1;
+    }
+
+    if (best.empty())
+    {
+        search.limit = low;
+        search.loads.assign(sides, 0);
+        if (!place(search, 0))
+            return shuffled;
+        best = search.placed;
+    }
+
+    std::vector<size_t> side(count);
+    for (size_t i = 0; i < count; ++i)
+        side[order[i]] = best[i];
+
+    auto album{createSides(sides)};
+    for (size_t i = 0; i < count; ++i)
+        album[side[i]].push(tracks[i]);
+
+    return createAlbum(std::move(album));
+}
+
+/**
+ * @brief Balance the tracks across sides as the configuration requires.
+ *
+ * @param tracks to be balanced.
+ * @param config the balancing configuration.
+ * @return Album the balanced sides.
+ */
+Album balance(const std::vector<Track> & tracks, const Config & config)
+{
+    const size_t sides{sideCount(tracks, config)};
+
+    if (config.force)
+        return bruteForce(tracks, sides);
+
+    if (config.shuffle)
+        return shuffleTracks(tracks, sides);
+
+    return splitTracks(tracks, sides, config.ideal);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file    Engine.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * In-process balancing engine, allowing tracks to be balanced without
+ * running the Balancer utility.
+ */
+
+#if !defined _ENGINE_H_INCLUDED_
+#define _ENGINE_H_INCLUDED_
+
+#include <vector>
+
+#include "Side.h"
+
+
+/**
+ * @section Define balancing configuration.
+ *
+ * Mirrors the Balancer options that control how the tracks are balanced.
+ */
+
+struct Config
+{
+    size_t boxes{};     // -b: number of boxes (sides) required.
+    size_t duration{};  // -d: maximum duration of a side in seconds.
+    bool even{};        // -e: require an even number of sides.
+    bool shuffle{};     // -s: reorder tracks to balance the sides.
+    bool force{};       // -f: brute force search for the best balance.
+    bool ideal{};       // -x: find the smallest achievable longest side.
+};
+
+
+/**
+ * @section balancing engine.
+ *
+ */
+
+extern size_t sideCount(const std::vector<Track> & tracks, const Config & config);
+
+extern Album splitTracks(const std::vector<Track> & tracks, size_t sides, bool ideal = false);
+extern Album shuffleTracks(const std::vector<Track> & tracks, size_t sides);
+extern Album bruteForce(const std::vector<Track> & tracks, size_t sides);
+
+extern Album balance(const std::vector<Track> & tracks, const Config & config);
+
+
+#endif //!defined _ENGINE_H_INCLUDED_
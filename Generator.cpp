@@ -0,0 +1,155 @@
+/**
+ * @file    Generator.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Seeded synthetic track list generation.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Generator.h"
+#include "Utilities.h"
+
+
+/**
+ * @section Support code.
+ *
+ */
+
+/**
+ * @brief A small, fast and portable random number generator (splitmix64).
+ */
+class Random
+{
+public:
+    Random(uint64_t seed) : state{seed} {}
+
+    uint64_t next(void)
+    {
+        const uint64_t value{splitMix64(state)};
+        state += splitMixGamma;
+
+        return value;
+    }
+
+    // Uniform in [0, 1), using the top 53 bits.
+    double unit(void) { return (next() >> 11) * 0x1.0p-53; }
+
+private:
+    uint64_t state;
+};
+
+/**
+ * @brief Generate a value in [0, 1] with the required distribution. The
+ * normal distribution is approximated by the sum of 12 uniform values and
+ * centred on the middle of the range. The exponential distribution has a
+ * mean of a fifth of the range, so most tracks are short. Both are clamped.
+ */
+static double generate(Random & random, Distribution distribution)
+{
+    switch (distribution)
+    {
+    case Distribution::normal:
+    {
+        double sum{};
+        for (int i = 0; i < 12; ++i)
+            sum += random.unit();
+
+        return std::clamp(0.5 + (sum - 6.0) / 6.0, 0.0, 1.0);
+    }
+
+    case Distribution::exponential:
+        return std::min(-std::log(1.0 - random.unit()) / 5.0, 1.0);
+
+    default:
+        break;
+    }
+
+    return random.unit();
+}
+
+
+/**
+ * @section track list generation.
+ *
+ */
+
+/**
+ * @brief Convert a distribution name to a Distribution.
+ * 
+ * @param name of the distribution, "uniform", "normal" or "exponential".
+ * @param distribution set if the name is recognised.
+ * @return true if the name is recognised, false otherwise.
+ */
+bool parseDistribution(const std::string & name, Distribution & distribution)
+{
+    if (name == "uniform")
+        distribution = Distribution::uniform;
+    else if (name == "normal")
+        distribution = Distribution::normal;
+    else if (name == "exponential")
+        distribution = Distribution::exponential;
+    else
+        return false;
+
+    return true;
+}
+
+/**
+ * @brief Generate a list of tracks, titled "Track 1" onwards, with durations
+ * between the minimum and maximum in the requested distribution. The titles
+ * are interned in the global pool, locking it once per track. The same
+ * titles are used by every call, so the pool only grows to the largest
+ * count generated.
+ * 
+ * @param spec of the tracks required.
+ * @return std::vector<Track> the generated tracks.
+ */
+std::vector<Track> generateTracks(const Spec & spec)
+{
+    Random random{spec.seed};
+    const size_t low{std::min(spec.minimum, spec.maximum)};
+    const size_t range{std::max(spec.minimum, spec.maximum) - low};
+
+    std::vector<Track> tracks{};
+    tracks.reserve(spec.count);
+    for (size_t i = 0; i < spec.count; ++i)
+    {
+        const size_t seconds{low + static_cast<size_t>(std::lround(generate(random, spec.distribution) * range))};
+        tracks.emplace_back("Track " + std::to_string(i+1), seconds);
+    }
+
+    return tracks;
+}
+
+/**
+ * @brief Format tracks as Balancer input, a duration and title per line.
+ * 
+ * @param out writer to format into.
+ * @param tracks to format.
+ */
+void formatInput(Writer & out, const std::vector<Track> & tracks)
+{
+    for (const auto & track : tracks)
+        out.appendTime(track.getValue(), false).append('\t').append(track.getTitle()).append('\n');
+}
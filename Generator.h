@@ -0,0 +1,67 @@
+/**
+ * @file    Generator.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Seeded synthetic track list generation. The same specification always
+ * generates the same tracks, on any platform, as the random numbers and the
+ * distributions are implemented here rather than taken from <random>.
+ */
+
+#if !defined _GENERATOR_H_INCLUDED_
+#define _GENERATOR_H_INCLUDED_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Side.h"
+#include "Writer.h"
+
+
+/**
+ * @section Define track list specification.
+ *
+ */
+
+enum class Distribution { uniform, normal, exponential };
+
+struct Spec
+{
+    size_t count{};                 // Number of tracks.
+    uint64_t seed{1};               // Random number seed.
+    Distribution distribution{};    // Shape of the track durations.
+    size_t minimum{60};             // Shortest track in seconds.
+    size_t maximum{600};            // Longest track in seconds.
+};
+
+
+/**
+ * @section track list generation.
+ *
+ */
+
+extern bool parseDistribution(const std::string & name, Distribution & distribution);
+extern std::vector<Track> generateTracks(const Spec & spec);
+extern void formatInput(Writer & out, const std::vector<Track> & tracks);
+
+
+#endif //!defined _GENERATOR_H_INCLUDED_
@@ -0,0 +1,388 @@
+/**
+ * @file    Oracle.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Exact optimality oracle. Two sides are solved with a bitset subset sum.
+ * More sides are solved by a binary search on the longest side, where each
+ * limit is checked by branch and bound, filling one side at a time, that
+ * finishes with the subset sum once only two sides remain. The branch and
+ * bound has a node budget, so a hard input gives no answer rather than hang.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <optional>
+
+#include "Oracle.h"
+
+
+/**
+ * @section Support code.
+ *
+ */
+
+/**
+ * @brief The set of subset sums reachable from [0, limit], held as a bitset.
+ */
+class Sums
+{
+public:
+    Sums(size_t high) : limit{high}, words((high + 64) / 64) { words[0] = 1; }
+
+    void add(size_t value);
+    bool any(size_t low, size_t high) const;
+    size_t highest(void) const;
+
+private:
+    const size_t limit;
+    std::vector<uint64_t> words;
+
+};
+
+/**
+ * @brief Add a value to every reachable sum, i.e. sums |= sums << value.
+ */
+void Sums::add(size_t value)
+{
+    if (value > limit)
+        return;
+
+    const size_t shift{value / 64};
+    const size_t bits{value % 64};
+    for (size_t i = words.size(); i-- > shift; )
+    {
+        uint64_t moved{words[i - shift] << bits};
+        if (bits && (i > shift))
+            moved |= words[i - shift - 1] >> (64 - bits);
+        words[i] |= moved;
+    }
+
+    // Drop any sums above the limit.
+    const size_t spare{(words.size() * 64) - (limit + 1)};
+    words.back() &= ~uint64_t{} >> spare;
+}
+
+/**
+ * @brief Determine if any sum in [low, high] is reachable.
+ */
+bool Sums::any(size_t low, size_t high) const
+{
+    high = std::min(high, limit);
+    for (size_t sum = low; sum <= high; )
+    {
+        const uint64_t word{words[sum / 64] >> (sum % 64)};
+        if (word)
+            return sum + std::countr_zero(word) <= high;
+        sum = (sum / 64 + 1) * 64;
+    }
+
+    return false;
+}
+
+size_t Sums::highest(void) const
+{
+    for (size_t i = words.size(); i-- > 0; )
+        if (words[i])
+            return i * 64 + 63 - std::countl_zero(words[i]);
+
+    return 0;
+}
+
+/**
+ * @brief Solve two sides exactly, giving the smallest achievable longest side.
+ */
+static size_t twoSides(std::span<const size_t> durations, size_t total)
+{
+    Sums sums{total / 2};
+    for (const auto duration : durations)
+        sums.add(duration);
+
+    return total - sums.highest();
+}
+
+/**
+ * @brief The longest side when placing the longest remaining track on the
+ * shortest side each time, an achievable upper bound.
+ */
+static size_t longestProcessingTime(std::span<const size_t> durations, size_t sides)
+{
+    std::vector<size_t> loads(sides);
+    for (const auto duration : durations)
+        *std::min_element(loads.begin(), loads.end()) += duration;
+
+    return *std::max_element(loads.begin(), loads.end());
+}
+
+/**
+ * @brief Determine if the tracks fit on two sides without exceeding the limit,
+ * i.e. if one side can take a subset whose complement fits on the other.
+ */
+static bool fitsTwo(std::span<const size_t> durations, size_t total, size_t limit)
+{
+    if (total > 2 * limit)
+        return false;
+
+    Sums sums{limit};
+    for (const auto duration : durations)
+        sums.add(duration);
+
+    return sums.any(total > limit ? total - limit : 0, limit);
+}
+
+/**
+ * @brief Buffers for one level of the search, reused by every fill at that
+ * level, so the leaves don't allocate.
+ */
+struct Scratch
+{
+    std::vector<size_t> remaining;      // Total duration of durations[i] onwards.
+    std::vector<bool> chosen;           // Tracks on the side.
+    std::vector<size_t> rest;           // Tracks left for the other sides.
+};
+
+/**
+ * @brief The search across every level, with the number of nodes it may
+ * visit before giving up.
+ */
+struct Search
+{
+    size_t budget;                      // Nodes left to visit.
+    bool exhausted;                     // true if the budget ran out.
+    std::vector<Scratch> levels;        // Indexed by the number of sides.
+};
+
+static bool fits(Search & search, std::span<const size_t> durations, size_t total, size_t sides, size_t limit);
+
+/**
+ * @brief Branch and bound search state for filling a single side with a
+ * subset of the tracks, the longest of which is always included.
+ */
+struct Fill
+{
+    std::span<const size_t> durations;  // Track durations, longest first.
+    Scratch & scratch;                  // Buffers for this level.
+    size_t total;                       // Total duration of all the tracks.
+    size_t sides;                       // Sides still to fill, including this one.
+    size_t limit;                       // Maximum side duration.
+    size_t low;                         // Minimum side duration.
+};
+
+/**
+ * @brief Try each way of filling the side from index onwards, then check the
+ * rest of the tracks fit on the other sides.
+ *
+ * Only maximal fills are tried, where no excluded track would fit, as moving
+ * such a track onto this side never stops the other sides fitting. Equal
+ * durations are only included in order, so no fill is tried twice.
+ *
+ * @param search the whole search, giving up once its budget is spent.
+ * @param fill search state.
+ * @param index of the next track to include or exclude.
+ * @param sum duration of the side so far.
+ * @param shortest excluded track, or 0 if none.
+ * @return true if the tracks fit, false otherwise or if the budget ran out.
+ */
+static bool fillSide(Search & search, Fill & fill, size_t index, size_t sum, size_t shortest)
+{
+    if (search.budget == 0)
+    {
+        search.exhausted = true;
+        return false;
+    }
+    --search.budget;
+
+    const size_t need{shortest ? std::max(fill.low, fill.limit - shortest + 1) : fill.low};
+    if (sum + fill.scratch.remaining[index] < need)
+        return false;
+
+    auto & chosen{fill.scratch.chosen};
+    const size_t count{fill.durations.size()};
+    if ((index == count) || (sum == fill.limit))
+    {
+        auto & rest{fill.scratch.rest};
+        rest.clear();
+        for (size_t i = 0; i < count; ++i)
+            if (!chosen[i])
+                rest.push_back(fill.durations[i]);
+
+        return fits(search, rest, fill.total - sum, fill.sides - 1, fill.limit);
+    }
+
+    const size_t duration{fill.durations[index]};
+    const bool repeat{(fill.durations[index-1] == duration) && !chosen[index-1]};
+    if (!repeat && (sum + duration <= fill.limit))
+    {
+        chosen[index] = true;
+        const bool found{fillSide(search, fill, index+1, sum + duration, shortest)};
+        chosen[index] = false;
+        if (found)
+            return true;
+    }
+
+    return fillSide(search, fill, index+1, sum, duration);
+}
+
+/**
+ * @brief Determine if the tracks fit on the sides without any side exceeding
+ * the limit, filling one side at a time until two remain.
+ *
+ * @param search the whole search, giving up once its budget is spent.
+ * @param durations of the tracks, longest first.
+ * @param total duration of the tracks.
+ * @param sides available.
+ * @param limit the maximum side duration.
+ * @return true if the tracks fit, false otherwise or if the budget ran out.
+ */
+static bool fits(Search & search, std::span<const size_t> durations, size_t total, size_t sides, size_t limit)
+{
+    if (total > sides * limit)
+        return false;
+
+    if (durations.empty() || (sides == 1))
+        return true;
+
+    if (durations.front() > limit)
+        return false;
+
+    if (sides == 2)
+        return fitsTwo(durations, total, limit);
+
+    const size_t count{durations.size()};
+    Fill fill{durations, search.levels[sides], total, sides, limit, 0};
+    auto & remaining{fill.scratch.remaining};
+    remaining.assign(count+1, 0);
+    for (size_t i = count; i > 0; --i)
+        remaining[i-1] = remaining[i] + durations[i-1];
+    fill.scratch.chosen.assign(count, false);
+
+    // Whatever the other sides can't take must be on this one.
+    const size_t others{(sides - 1) * limit};
+    fill.low = total > others ? total - others : 0;
+    fill.scratch.chosen[0] = true;
+
+    return fillSide(search, fill, 1, durations.front(), 0);
+}
+
+
+/**
+ * @section optimality oracle.
+ *
+ */
+
+/**
+ * @brief Calculate the smallest achievable longest side when the tracks may
+ * be arranged on the sides in any order. With more than two sides, proving
+ * a limit can't be met may take exponential time, so the search gives up
+ * once it has visited the budgeted number of nodes.
+ *
+ * @param durations of the tracks.
+ * @param sides the number of sides.
+ * @param budget the number of search nodes to visit before giving up.
+ * @return std::optional<size_t> the optimal longest side, or none if the
+ * budget ran out first.
+ */
+std::optional<size_t> optimalLongestSide(std::span<const size_t> durations, size_t sides, size_t budget)
+{
+    if (durations.empty())
+        return 0;
+
+    std::vector<size_t> sorted(durations.begin(), durations.end());
+    std::sort(sorted.begin(), sorted.end(), std::greater<size_t>{});
+
+    const size_t count{sorted.size()};
+    const size_t total{std::accumulate(sorted.begin(), sorted.end(), size_t{})};
+    sides = std::max(sides, size_t{1});
+    if (sides >= count)
+        return sorted.front();
+
+    // The k+1 longest tracks can't all be on different sides.
+    const size_t lower{std::max({(total + sides - 1) / sides, sorted.front(), sorted[sides-1] + sorted[sides]})};
+    const size_t upper{longestProcessingTime(sorted, sides)};
+    if ((sides == 1) || (lower >= upper))
+        return upper;
+
+    if (sides == 2)
+        return twoSides(sorted, total);
+
+    Search search{budget, false, std::vector<Scratch>(sides + 1)};
+    for (auto & level : search.levels)
+        level.rest.reserve(count);
+
+    // The lower bound is usually achievable, so try it first.
+    if (fits(search, sorted, total, sides, lower))
+        return lower;
+
+    size_t low{lower + 1};
+    size_t high{upper};
+    while ((low < high) && !search.exhausted)
+    {
+        const size_t mid{low + (high - low) / 2};
+        if (fits(search, sorted, total, sides, mid))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    if (search.exhausted)
+        return std::nullopt;
+
+    return low;
+}
+
+/**
+ * @brief Calculate the smallest achievable longest side for the tracks on
+ * the album, across the same number of sides.
+ *
+ * @param album to check.
+ * @param budget the number of search nodes to visit before giving up.
+ * @return std::optional<size_t> the optimal longest side, or none if the
+ * budget ran out first.
+ */
+std::optional<size_t> optimalLongestSide(const Album & album, size_t budget)
+{
+    std::vector<size_t> durations{};
+    for (const auto & side : album)
+        for (const auto & track : side)
+            durations.push_back(track.getValue());
+
+    return optimalLongestSide(durations, album.size(), budget);
+}
+
+/**
+ * @brief Determine if the longest side of the album is as short as possible.
+ *
+ * @param album to check.
+ * @param budget the number of search nodes to visit before giving up.
+ * @return true if the album is proven to be optimally balanced, false if it
+ * isn't or if the budget ran out first.
+ */
+bool isOptimal(const Album & album, size_t budget)
+{
+    size_t longest{};
+    for (const auto & side : album)
+        longest = std::max(longest, side.getValue());
+
+    return optimalLongestSide(album, budget) == longest;
+}
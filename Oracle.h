@@ -0,0 +1,51 @@
+/**
+ * @file    Oracle.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Exact optimality oracle, giving the smallest achievable longest side when
+ * the tracks may be placed on the sides in any arrangement.
+ */
+
+#if !defined _ORACLE_H_INCLUDED_
+#define _ORACLE_H_INCLUDED_
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Side.h"
+
+
+/**
+ * @section optimality oracle.
+ *
+ */
+
+// Search nodes visited before the oracle gives up, well under a second.
+const size_t oracleBudget{100000000};
+
+extern std::optional<size_t> optimalLongestSide(std::span<const size_t> durations, size_t sides, size_t budget = oracleBudget);
+extern std::optional<size_t> optimalLongestSide(const Album & album, size_t budget = oracleBudget);
+extern bool isOptimal(const Album & album, size_t budget = oracleBudget);
+
+
+#endif //!defined _ORACLE_H_INCLUDED_
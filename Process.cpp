@@ -0,0 +1,212 @@
+/**
+ * @file    Process.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Child process launching with the standard output captured in memory.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+#include <spawn.h>
+#include <signal.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "Process.h"
+
+extern char ** environ;
+
+
+/**
+ * @section child process support.
+ *
+ */
+
+/**
+ * @brief Split a command line into arguments at white space, as the shell
+ * would. Single or double quotes group characters into one argument and are
+ * removed.
+ * 
+ * @param line to be split.
+ * @return std::vector<std::string> the arguments.
+ */
+std::vector<std::string> splitArguments(const std::string & line)
+{
+    std::vector<std::string> args{};
+    std::string arg{};
+    bool inArg{};
+    char quote{};
+
+    for (const auto c : line)
+    {
+        if (quote)
+        {
+            if (c == quote)
+                quote = 0;
+            else
+                arg += c;
+        }
+        else if ((c == '\'') || (c == '"'))
+        {
+            quote = c;
+            inArg = true;
+        }
+        else if ((c == ' ') || (c == '\t'))
+        {
+            if (inArg)
+                args.push_back(std::move(arg));
+            arg.clear();
+            inArg = false;
+        }
+        else
+        {
+            arg += c;
+            inArg = true;
+        }
+    }
+
+    if (inArg)
+        args.push_back(std::move(arg));
+
+    return args;
+}
+
+/**
+ * @brief Run a program, found using PATH, without a shell and capture its
+ * standard output over a pipe. The child is reaped with wait4() to collect
+ * the resources it used.
+ * 
+ * @param args the program name followed by its arguments.
+ * @param timeout in seconds after which the child is killed, 0 for none,
+ * even if it has closed its standard output.
+ * @return Result the wait status, the captured output and the resource
+ * usage. The status is non-zero if the program could not be started.
+ */
+Result spawn(const std::vector<std::string> & args, double timeout)
+{
+    Result result{-1, {}, {}, false};
+    if (args.empty())
+        return result;
+
+    std::vector<char *> argv{};
+    argv.reserve(args.size() + 1);
+    for (const auto & arg : args)
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    // Close on exec, so that concurrently spawned children do not inherit
+    // the pipe and hold it open.
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC))
+        return result;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+    const auto start{std::chrono::steady_clock::now()};
+    pid_t pid{};
+    const int error{posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ)};
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    if (error)
+    {
+        close(fds[0]);
+        return result;
+    }
+
+    // The deadline covers the whole life of the child, including any time
+    // after it closes its standard output.
+    const auto deadline{start + std::chrono::duration<double>{timeout}};
+    auto remaining{[&deadline]()
+    {
+        const auto left{std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now())};
+        return std::max(left.count(), std::chrono::milliseconds::rep{0});
+    }};
+    auto stop{[&result, pid](bool late) { kill(pid, SIGKILL); result.timedOut = late; }};
+
+    bool killed{};
+    char buffer[64 * 1024];
+    for (;;)
+    {
+        if (timeout > 0)
+        {
+            // Wait for output until the deadline, then kill the child.
+            const auto left{remaining()};
+            pollfd ready{fds[0], POLLIN, 0};
+            const int polled{left > 0 ? poll(&ready, 1, static_cast<int>(left)) : 0};
+            if ((polled == -1) && (errno == EINTR))
+                continue;
+
+            if (polled <= 0)
+            {
+                stop(polled == 0);
+                killed = true;
+                break;
+            }
+        }
+
+        const ssize_t count{read(fds[0], buffer, sizeof(buffer))};
+        if (count > 0)
+            result.output.append(buffer, count);
+        else if ((count == 0) || (errno != EINTR))
+            break;
+    }
+    close(fds[0]);
+
+    struct rusage usage{};
+    bool reaped{};
+    if ((timeout > 0) && !killed)
+    {
+        // The output is closed, wait for the child to exit until the deadline.
+        for (;;)
+        {
+            const pid_t waited{wait4(pid, &result.status, WNOHANG, &usage)};
+            if ((waited == pid) || ((waited == -1) && (errno != EINTR)))
+            {
+                reaped = (waited == pid);
+                break;
+            }
+
+            const auto left{remaining()};
+            if (left == 0)
+            {
+                stop(true);
+                break;
+            }
+            usleep(static_cast<useconds_t>(std::min(left, std::chrono::milliseconds::rep{5})) * 1000);
+        }
+    }
+
+    while (!reaped && (wait4(pid, &result.status, 0, &usage) == -1))
+        if (errno != EINTR)
+            break;
+
+    const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+    auto seconds{[](const timeval & time) { return time.tv_sec + time.tv_usec / 1e6; }};
+    result.usage = Usage{elapsed.count(), seconds(usage.ru_utime), seconds(usage.ru_stime),
+        usage.ru_maxrss, usage.ru_minflt, usage.ru_majflt};
+
+    return result;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file    Process.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Child process launching with the standard output captured in memory.
+ */
+
+#if !defined _PROCESS_H_INCLUDED_
+#define _PROCESS_H_INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section child process support.
+ *
+ */
+
+struct Usage
+{
+    double wall;        // Elapsed time from start to exit in seconds.
+    double user;        // User CPU time in seconds.
+    double system;      // System CPU time in seconds.
+    long maxRss;        // Peak resident set size in kilobytes.
+    long minorFaults;   // Page faults serviced without I/O.
+    long majorFaults;   // Page faults that required I/O.
+};
+
+struct Result
+{
+    int status;         // Wait status, as returned by system().
+    std::string output; // Everything the child wrote to stdout.
+    Usage usage;        // Resources used by the child.
+    bool timedOut;      // true if the child was killed for taking too long.
+};
+
+extern std::vector<std::string> splitArguments(const std::string & line);
+extern Result spawn(const std::vector<std::string> & args, double timeout = 0);
+
+
+#endif //!defined _PROCESS_H_INCLUDED_
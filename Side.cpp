@@ -25,30 +25,153 @@
  */
 
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <bit>
 
 #include "Side.h"
 #include "Utilities.h"
 
 
 
+/**
+ * @section Define Titles class.
+ *
+ */
+
+/**
+ * @brief Intern a title, copying it into the pool only if it is not
+ * already there.
+ * 
+ * @param title to intern.
+ * @return std::string_view the pooled copy of the title.
+ */
+std::string_view Titles::intern(std::string_view title)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    const auto it{index.find(title)};
+    if (it != index.end())
+        return *it;
+
+    return *index.insert(append(title)).first;
+}
+
+/**
+ * @brief Store a title in the pool without looking for an existing copy.
+ * This is much faster for the mostly distinct titles of a loaded album.
+ * 
+ * @param title to store.
+ * @return std::string_view the pooled copy of the title.
+ */
+std::string_view Titles::store(std::string_view title)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    return append(title);
+}
+
+/**
+ * @brief Copy a title to the end of the pool.
+ */
+std::string_view Titles::append(std::string_view title)
+{
+    if (blocks.empty() || (used + title.size() > capacity))
+    {
+        // Oversized titles get a block of their own.
+        capacity = std::max(blockSize, title.size());
+        blocks.push_back(std::make_unique<char[]>(capacity));
+        used = 0;
+    }
+
+    char * text{blocks.back().get() + used};
+    std::char_traits<char>::copy(text, title.data(), title.size());
+    used += title.size();
+
+    return std::string_view{text, title.size()};
+}
+
+/**
+ * @brief The pool used by tracks that are not created from an album. It is
+ * never destroyed, so these titles remain valid for the life of the program.
+ */
+Titles & Titles::global(void)
+{
+    static Titles * pool{new Titles{}};
+
+    return *pool;
+}
+
+
 /**
  * @section Define Track support.
  *
  */
 
+// Formatted line size, excluding the title, allowing for a CSV duration.
+static const size_t lineSize{32};
+
+/**
+ * @brief Estimate the formatted size of a side, to size its Writer.
+ * 
+ * @param side to estimate.
+ * @return size_t the estimated number of characters.
+ */
+static size_t formattedSize(const Side & side)
+{
+    size_t size{2 * lineSize + side.getTitle().size()};
+    for (const auto & track : side)
+        size += lineSize + track.getTitle().size();
+
+    return size;
+}
+
+/**
+ * @brief Estimate the formatted size of an album, to size its Writer.
+ * 
+ * @param album to estimate.
+ * @return size_t the estimated number of characters.
+ */
+static size_t formattedSize(const Album & album)
+{
+    size_t size{lineSize + album.getTitle().size()};
+    for (const auto & side : album)
+        size += formattedSize(side);
+
+    return size;
+}
+
 bool Track::stream(std::ostream & os, bool plain, bool csv) const
 {
-    std::string time{plain ? std::to_string(seconds) : secondsToTimeString(seconds)};
+    Writer out{};
+    format(out, plain, csv);
+
+    return out.write(os);
+}
 
-    os << "    ";
-    const std::string c{oSep};
+void Track::format(Writer & out, bool plain, bool csv) const
+{
+    TimeBuffer buffer;
+
+    formatTime(out, secondsToString(seconds, buffer, plain), csv);
+}
+
+/**
+ * @brief Format the track using an already formatted duration.
+ * 
+ * @param out writer to format into.
+ * @param time the formatted duration of the track.
+ * @param csv true for CSV output.
+ */
+void Track::formatTime(Writer & out, std::string_view time, bool csv) const
+{
+    out.append("    ");
     if (csv)
-        os << "Track" << c << time << c << "\"" << title << "\"";
+        out.append("Track").append(oSep).append(time).append(oSep).append('"').append(getTitle()).append('"');
     else
-        os << time << " - " << title;
-    os << "\n";
-
-    return true;
+        out.append(time).append(" - ").append(getTitle());
+    out.append('\n');
 }
 
 
@@ -57,71 +180,184 @@ bool Track::stream(std::ostream & os, bool plain, bool csv) const
  *
  */
 
+/**
+ * @brief Add the next value to the fingerprint. Each lane mixes the value in
+ * differently, so a collision needs both 64-bit lanes to collide at once.
+ * 
+ * @param value to add.
+ */
+void Fingerprint::add(uint64_t value)
+{
+    low = splitMix64(low + value);
+    high = splitMix64(std::rotl(high, 23) ^ (value * 0xc2b2ae3d27d4eb4f));
+}
+
+/**
+ * @brief Copy or move a side into storage from the given allocator, as when
+ * it is added to an album with its own memory resource.
+ */
+Side::Side(const Side & other, const allocator_type & allocator) :
+    title{other.title, allocator}, seconds{other.seconds}, hash{other.hash}, tracks{other.tracks, allocator},
+    cached{other.cached}, plainTimes{other.plainTimes}, timeText{other.timeText, allocator}, timeEnds{other.timeEnds, allocator}
+{
+}
+
+Side::Side(Side && other, const allocator_type & allocator) :
+    title{std::move(other.title), allocator}, seconds{other.seconds}, hash{other.hash}, tracks{std::move(other.tracks), allocator},
+    cached{other.cached}, plainTimes{other.plainTimes}, timeText{std::move(other.timeText), allocator}, timeEnds{std::move(other.timeEnds), allocator}
+{
+}
+
+/**
+ * @brief Add a track to the side. The hash is the sum of the mixed track
+ * durations, so it is updated here and in pop() without a rebuild.
+ * 
+ * @param track to add.
+ */
 void Side::push(const Track & track)
 {
     tracks.push_back(track);
     seconds += track.getValue();
+    hash += splitMix64(track.getValue());
+    clearTimes();
 }
 
 void Side::pop(void)
 {
     seconds -= tracks.back().getValue();
+    hash -= splitMix64(tracks.back().getValue());
     tracks.pop_back();
+    clearTimes();
 }
 
+/**
+ * @brief Calculate the canonical fingerprint of the side, from the track
+ * count and the sorted track durations, so the track order is ignored.
+ * 
+ * @return Fingerprint the fingerprint of the side.
+ */
+Fingerprint Side::getFingerprint(void) const
+{
+    std::vector<size_t> durations{};
+    durations.reserve(size());
+    for (const auto & track : tracks)
+        durations.push_back(track.getValue());
+    std::sort(durations.begin(), durations.end());
+
+    Fingerprint fingerprint{};
+    fingerprint.add(durations.size());
+    for (const auto duration : durations)
+        fingerprint.add(duration);
+
+    return fingerprint;
+}
 
-size_t Side::getHash(void)
+/**
+ * @brief Format the durations of the tracks followed by that of the side
+ * into the cache in one pass, only if the cache is out of date.
+ * 
+ * @param plain true for a plain number of seconds.
+ */
+void Side::formatTimes(bool plain) const
 {
-    if (!hash)
+    if (!timeEnds.empty() && (plainTimes == plain))
+        return;
+
+    TimeBuffer buffer;
+    clearTimes();
+    timeEnds.reserve(size() + 1);
+    auto add{[&](size_t value)
     {
-        hash = size();
+        timeText.append(secondsToString(value, buffer, plain));
+        timeEnds.push_back(static_cast<uint32_t>(timeText.size()));
+    }};
+    for (const auto & track : tracks)
+        add(track.getValue());
+    add(seconds);
+    plainTimes = plain;
+}
 
-        std::multiset<size_t> values{};
-        for (const auto & track : tracks)
-            values.insert(track.getValue());
+/**
+ * @brief Get a cached duration, formatTimes() must be called first.
+ * 
+ * @param index of the track, or size() for the side.
+ * @return std::string_view the formatted duration.
+ */
+std::string_view Side::getTime(size_t index) const
+{
+    const uint32_t first{index ? timeEnds[index-1] : 0};
 
+    return {timeText.data() + first, timeEnds[index] - first};
+}
 
-        // std::cout << "  ";
-        for (const auto & value : values)
-        {
-            hash <<= 1;
-            hash ^= std::hash<size_t>{}(value);
-            // std::cout << value << " ";
-        }
-        // std::cout << "\n";
-        // std::cout << "hash: " << hash << "\n";
-    }
+/**
+ * @brief Stream the side and its tracks, formatted into a single buffer.
+ * 
+ * @param os output stream.
+ * @param plain true for a plain number of seconds.
+ * @param csv true for CSV output.
+ * @return true if the side was streamed.
+ */
+bool Side::stream(std::ostream & os, bool plain, bool csv) const
+{
+    Writer out{formattedSize(*this)};
+    format(out, plain, csv);
 
-    return hash;
+    return out.write(os);
 }
 
-bool Side::stream(std::ostream & os, bool plain, bool csv) const
+bool Side::summary(std::ostream & os, bool plain) const
+{
+    Writer out{};
+    formatSummary(out, plain);
+
+    return out.write(os);
+}
+
+/**
+ * @brief Format the side and its tracks. If the times are cached, the
+ * durations are only formatted the first time the side is formatted.
+ * 
+ * @param out writer to format into.
+ * @param plain true for a plain number of seconds.
+ * @param csv true for CSV output.
+ */
+void Side::format(Writer & out, bool plain, bool csv) const
 {
-    std::string time{plain ? std::to_string(seconds) : secondsToTimeString(seconds)};
+    TimeBuffer buffer;
+    if (cached)
+        formatTimes(plain);
+    const std::string_view time{cached ? getTime(size()) : secondsToString(seconds, buffer, plain)};
 
-    os << "  ";
-    const std::string c{oSep};
+    out.append("  ");
     if (csv)
-        os << "Side" << c << time << c << "\"" << title << ", " << std::to_string(size()) << " tracks\"";
+        out.append("Side").append(oSep).append(time).append(oSep).append('"').append(title).append(", ").appendNumber(size()).append(" tracks\"");
     else
-        os << title << " - " << std::to_string(size()) << " tracks";
-    os << "\n";
+        out.append(title).append(" - ").appendNumber(size()).append(" tracks");
+    out.append('\n');
 
-    for (const auto & track : tracks)
-        track.stream(os, plain, csv);
+    if (cached)
+    {
+        for (size_t i = 0; i < size(); ++i)
+            tracks[i].formatTime(out, getTime(i), csv);
+    }
+    else
+    {
+        for (const auto & track : tracks)
+            track.format(out, plain, csv);
+    }
 
     if (!csv)
-        os << "  " << time << "\n\n";
-
-    return true;
+        out.append("  ").append(time).append("\n\n");
 }
 
-bool Side::summary(std::ostream & os, bool plain) const
+void Side::formatSummary(Writer & out, bool plain) const
 {
-    const std::string time{plain ? std::to_string(seconds) : secondsToTimeString(seconds)};
-    os << getTitle() << " - " << size() << " tracks " << time << "\n";
-
-    return true;
+    TimeBuffer buffer;
+    if (cached)
+        formatTimes(plain);
+    const std::string_view time{cached ? getTime(size()) : secondsToString(seconds, buffer, plain)};
+    out.append(title).append(" - ").appendNumber(size()).append(" tracks ").append(time).append('\n');
 }
 
 
@@ -130,58 +366,208 @@ bool Side::summary(std::ostream & os, bool plain) const
  *
  */
 
+/**
+ * @brief Add a side to the album. The hash is the sum of the mixed side
+ * hashes, so it is updated here, in pop() and in pushLast() without any
+ * allocation.
+ * 
+ * @param side to add.
+ */
 void Album::push(const Side & side)
 {
     sides.push_back(side);
     seconds += side.getValue();
+    hash += splitMix64(side.getHash());
+}
+
+/**
+ * @brief Move a side into the album, leaving its tracks in place when the
+ * album uses the same memory resource.
+ * 
+ * @param side to add.
+ */
+void Album::push(Side && side)
+{
+    seconds += side.getValue();
+    hash += splitMix64(side.getHash());
+    sides.push_back(std::move(side));
+}
+
+/**
+ * @brief Add an empty side, constructed in place, for pushLast() to fill.
+ * 
+ * @param t the title of the side.
+ */
+void Album::emplace(std::string_view t)
+{
+    // An empty side has a zero hash.
+    hash += splitMix64(0);
+    sides.emplace_back().setTitle(t);
 }
 
 void Album::pop()
 {
     seconds -= sides.back().getValue();
+    hash -= splitMix64(sides.back().getHash());
     sides.pop_back();
 }
 
-size_t Album::getHash(void)
+/**
+ * @brief Add a track to the last side of the album.
+ * 
+ * @param track to add.
+ */
+void Album::pushLast(const Track & track)
 {
-    if (!hash)
+    auto & side{sides.back()};
+    hash -= splitMix64(side.getHash());
+    side.push(track);
+    hash += splitMix64(side.getHash());
+    seconds += track.getValue();
+}
+
+/**
+ * @brief Calculate the canonical fingerprint of the album, from the side
+ * count and the sorted side fingerprints, so the side order is ignored.
+ * 
+ * @return Fingerprint the fingerprint of the album.
+ */
+Fingerprint Album::getFingerprint(void) const
+{
+    std::vector<Fingerprint> fingerprints{};
+    fingerprints.reserve(size());
+    for (const auto & side : sides)
+        fingerprints.push_back(side.getFingerprint());
+    std::sort(fingerprints.begin(), fingerprints.end());
+
+    Fingerprint fingerprint{};
+    fingerprint.add(fingerprints.size());
+    for (const auto & side : fingerprints)
     {
-        hash = size();
+        fingerprint.add(side.high);
+        fingerprint.add(side.low);
+    }
+
+    return fingerprint;
+}
+
+/**
+ * @brief Parse the sides and tracks of a CSV album, as produced by Balancer,
+ * straight from a raw buffer in a single pass. Each side is reserved for the
+ * track count in its header and the track titles are stored in the album's
+ * title pool, without interning them. Parsing stops at a side header without a track count.
+ * 
+ * Only complete lines are parsed, so a partial line at the end of the buffer
+ * may be passed again, with the rest of the line, in a later call.
+ * 
+ * @param text to parse.
+ * @return size_t the number of characters consumed.
+ */
+size_t Album::parse(std::string_view text)
+{
+    Titles & pool{getTitles()};
+    Side * side{sides.empty() ? nullptr : &sides.back()};
+    if (side)
+        hash -= splitMix64(side->getHash());
 
-        std::multiset<size_t> values{};
-        for (auto & side : sides)
-            values.insert(side.getHash());
+    size_t start{};
+    for (size_t end{}; (end = text.find('\n', start)) != std::string_view::npos; start = end + 1)
+    {
+        // Truncate the line at any CR or NUL.
+        const auto last{std::find_if(text.begin() + start, text.begin() + end, [](char c) { return (c == '\r') || (c == '\0'); })};
+        const std::string_view line{text.begin() + start, last};
 
-        for (const auto & value : values)
+        std::array<std::string_view, 3> tokens{};
+        if (split(line, tokens) < tokens.size())
+            continue;
+
+        const std::string_view label{tokens[2]};
+        if (tokens[0] == "Side")
         {
-            hash <<= 1;
-            hash ^= std::hash<size_t>{}(value);
-            // std::cout << value << " ";
+            // Find track count.
+            const size_t pos{label.find(',')};
+            if (pos == std::string_view::npos)
+            {
+                start = text.size();
+                break;
+            }
+
+            const size_t first{label.find_first_not_of(' ', pos+1)};
+            const std::string_view count{first == std::string_view::npos ? std::string_view{} : label.substr(first)};
+            size_t tracks{};
+            std::from_chars(count.data(), count.data() + count.size(), tracks);
+
+            if (side)
+                hash += splitMix64(side->getHash());
+            side = &sides.emplace_back();
+            side->reserve(tracks);
+            side->setTitle(label.substr(0, pos));
+        }
+        else if (side)
+        {
+            const size_t duration{timeStringToSeconds(tokens[1])};
+            side->push(Track::pooled(pool.store(label), duration));
+            seconds += duration;
         }
-        // std::cout << "\n";
-        // std::cout << "hash: " << hash << "\n";
     }
 
-    return hash;
+    if (side)
+        hash += splitMix64(side->getHash());
+
+    return start;
 }
 
-bool Album::stream(std::ostream & os, bool plain, bool csv) const
+/**
+ * @brief Get the title pool shared by the album and its copies, creating it
+ * on first use.
+ * 
+ * @return Titles& the title pool.
+ */
+Titles & Album::getTitles(void)
 {
-    os << title << ":\n";
+    if (!titles)
+        titles = std::make_shared<Titles>();
 
-    for (const auto & side : sides)
-        side.stream(std::cout, plain, csv);
+    return *titles;
+}
 
-    std::string time{plain ? std::to_string(seconds) : secondsToTimeString(seconds)};
-    os << time << "\n";
+/**
+ * @brief Stream the album, formatting all of the sides into a single buffer
+ * that is written to the stream in one call.
+ * 
+ * @param os output stream.
+ * @param plain true for a plain number of seconds.
+ * @param csv true for CSV output.
+ * @return true if the album was streamed.
+ */
+bool Album::stream(std::ostream & os, bool plain, bool csv) const
+{
+    Writer out{formattedSize(*this)};
+    format(out, plain, csv);
 
-    return true;
+    return out.write(os);
 }
 
 bool Album::summary(std::ostream & os, bool plain) const
 {
+    Writer out{size() * lineSize};
+    formatSummary(out, plain);
+
+    return out.write(os);
+}
+
+void Album::format(Writer & out, bool plain, bool csv) const
+{
+    out.append(title).append(":\n");
+
     for (const auto & side : sides)
-        side.summary(std::cout, plain);
+        side.format(out, plain, csv);
+
+    out.appendTime(seconds, plain).append('\n');
+}
 
-    return true;
+void Album::formatSummary(Writer & out, bool plain) const
+{
+    for (const auto & side : sides)
+        side.formatSummary(out, plain);
 }
@@ -28,54 +28,160 @@
 #define _SIDE_H_INCLUDED_
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
+#include <memory_resource>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <unordered_set>
+#include <type_traits>
+#include <compare>
+#include <limits>
+#include <stdexcept>
 
 #include "Utilities.h"
+#include "Writer.h"
+
+
+/**
+ * @section Define Titles class.
+ *
+ * An append only pool of interned track titles. Each distinct title is
+ * stored once and the returned views remain valid for the life of the pool.
+ */
+
+class Titles
+{
+public:
+    Titles(void) : used{}, capacity{} {}
+    Titles(const Titles &) = delete;
+    Titles & operator=(const Titles &) = delete;
+
+    std::string_view intern(std::string_view title);
+    std::string_view store(std::string_view title);
+    size_t size(void) const { std::lock_guard<std::mutex> lock{mutex}; return index.size(); }
+
+    static Titles & global(void);
+
+private:
+    static constexpr size_t blockSize{16*1024};
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t used;
+    size_t capacity;
+    std::unordered_set<std::string_view> index;
+
+    std::string_view append(std::string_view title);
+
+};
+
+
+/**
+ * @section Define Fingerprint struct.
+ *
+ * A well mixed 128-bit fingerprint, built from a sequence of values in two
+ * independently mixed 64-bit lanes. Unlike the incremental hashes it is
+ * canonical rather than maintained, so it is calculated on demand.
+ */
+
+struct Fingerprint
+{
+    uint64_t high{};
+    uint64_t low{};
+
+    void add(uint64_t value);
+
+    auto operator<=>(const Fingerprint &) const = default;
+};
 
 
 /**
  * @section Define Track class.
  *
+ * A Track is a handle to an interned title and a 32-bit duration, so it is
+ * trivially copyable. Tracks constructed without a pool use the global pool,
+ * which is never freed and locks a mutex for each track, so code making many
+ * tracks, such as a parser, should use its own pool.
  */
 
 class Track
 {
 public:
-    Track(const std::string & t, size_t s) : title{t}, seconds{s} { }
+    Track(std::string_view t, size_t s) : Track{Titles::global(), t, s} { }
+    Track(Titles & titles, std::string_view t, size_t s) : Track{pooled(titles.intern(t), s)} { }
 
-    std::string getTitle() const { return title; }
+    std::string_view getTitle() const { return {text, length}; }
     size_t getValue() const { return seconds; }
 
     bool stream(std::ostream & os, bool plain=false, bool csv=false) const;
+    void format(Writer & out, bool plain=false, bool csv=false) const;
+    void formatTime(Writer & out, std::string_view time, bool csv=false) const;
 
 private:
-    const std::string title;
-    const size_t seconds;
+    friend class Album;
+    friend class AlbumFile;
+
+    // The title must already be held by a pool that outlives the track.
+    static Track pooled(std::string_view t, size_t s) { return Track{t.data(), t.size(), s}; }
+
+    Track(const char * t, size_t l, size_t s) : text{t}, length{narrow(l)}, seconds{narrow(s)} { }
+
+    // Reject a title length or duration that doesn't fit in 32 bits.
+    static uint32_t narrow(size_t value)
+    {
+        if (value > std::numeric_limits<uint32_t>::max())
+            throw std::out_of_range{"Track title or duration is too large"};
+
+        return static_cast<uint32_t>(value);
+    }
+
+    const char * text;
+    uint32_t length;
+    uint32_t seconds;
 };
 
+static_assert(std::is_trivially_copyable_v<Track>);
+
 
 /**
  * @section Define Side class.
  *
+ * A Side holds tracks, not their titles, so it must not outlive the pool the
+ * titles are in. A side copied out of an album that owns its titles, such as
+ * a parsed or loaded album, is only valid while that album or a copy of it
+ * exists.
  */
 
 class Side
 {
 public:
-    using Iterator = std::vector<Track>::const_iterator;
-
-    Side(void) : title{}, seconds{}, hash{} {}
-
-    void setTitle(const std::string & t) { title = t; }
+    using Iterator = std::pmr::vector<Track>::const_iterator;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Side(void) : Side{allocator_type{}} {}
+    explicit Side(const allocator_type & allocator) : title{allocator}, seconds{}, hash{}, tracks{allocator}, timeText{allocator}, timeEnds{allocator} {}
+    Side(const Side & other) = default;
+    Side(Side && other) = default;
+    Side(const Side & other, const allocator_type & allocator);
+    Side(Side && other, const allocator_type & allocator);
+    Side & operator=(const Side & other) = default;
+    Side & operator=(Side && other) = default;
+
+    void setTitle(std::string_view t) { title.assign(t); }
     void reserve(size_t len) { tracks.reserve(len); }
 
+    template<typename... Args>
+    void emplace(Args &&... args) { push(Track(std::forward<Args>(args)...)); }
+
     void push(const Track & track);
     void pop(void);
 
-    const std::string & getTitle() const { return title; }
+    std::string_view getTitle() const { return title; }
     size_t getValue(void) const { return seconds; }
-    size_t getHash(void);
+    size_t getHash(void) const { return hash; }
+    Fingerprint getFingerprint(void) const;
 
     size_t size(void) const { return tracks.size(); }
     Iterator begin(void) const { return tracks.begin(); }
@@ -83,14 +189,30 @@ public:
 
     bool stream(std::ostream & os, bool plain=false, bool csv=false) const;
     bool summary(std::ostream & os, bool plain=false) const;
+    void format(Writer & out, bool plain=false, bool csv=false) const;
+    void formatSummary(Writer & out, bool plain=false) const;
+
+    void clear(void) { seconds = 0; hash = 0; tracks.clear(); clearTimes(); }
 
-    void clear(void) { seconds = 0; tracks.clear(); }
+    void cacheTimes(bool enable = true) { cached = enable; clearTimes(); }
 
 private:
-    std::string title;
+    std::pmr::string title;
     size_t seconds;
     size_t hash;
-    std::vector<Track> tracks;
+    std::pmr::vector<Track> tracks;
+
+    // Formatted track durations followed by the side duration, when cached.
+    // They are held in one buffer, with the end offset of each duration, so
+    // refreshing them reuses the same memory.
+    bool cached{};
+    mutable bool plainTimes{};
+    mutable std::pmr::string timeText;
+    mutable std::pmr::vector<uint32_t> timeEnds;
+
+    void clearTimes(void) const { timeText.clear(); timeEnds.clear(); }
+    void formatTimes(bool plain) const;
+    std::string_view getTime(size_t index) const;
 
 };
 
@@ -98,24 +220,33 @@ private:
 /**
  * @section Define Album class.
  *
+ * An Album may be given a memory resource, such as an arena, that then holds
+ * its title, its sides and their titles, tracks and cached times. Copies of
+ * the album use the default resource. The track titles are interned in a
+ * Titles pool, not in the resource.
  */
 
 class Album
 {
 public:
-    using Iterator = std::vector<Side>::const_iterator;
+    using Iterator = std::pmr::vector<Side>::const_iterator;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
 
-    Album(void) : title{}, seconds{}, hash{} {}
+    Album(void) : Album{allocator_type{}} {}
+    explicit Album(const allocator_type & allocator) : title{allocator}, seconds{}, hash{}, sides{allocator} {}
 
-    void setTitle(const std::string & t) { title = t; }
-    // void reserve(size_t len) { sides.reserve(len); }
+    void setTitle(std::string_view t) { title.assign(t); }
+    void reserve(size_t len) { sides.reserve(len); }
 
     void push(const Side & side);
+    void push(Side && side);
+    void emplace(std::string_view t);
     void pop(void);
 
-    const std::string & getTitle() const { return title; }
+    std::string_view getTitle() const { return title; }
     size_t getValue(void) const { return seconds; }
-    size_t getHash(void);
+    size_t getHash(void) const { return hash; }
+    Fingerprint getFingerprint(void) const;
 
     size_t size(void) const { return sides.size(); }
     Iterator begin(void) const { return sides.begin(); }
@@ -123,17 +254,27 @@ public:
 
     bool stream(std::ostream & os, bool plain=false, bool csv=false) const;
     bool summary(std::ostream & os, bool plain=false) const;
+    void format(Writer & out, bool plain=false, bool csv=false) const;
+    void formatSummary(Writer & out, bool plain=false) const;
+
+    size_t parse(std::string_view text);
 
-    void clear(void) { seconds = 0; for (auto item : sides) item.clear(); sides.clear(); }
+    Titles & getTitles(void);
+    Track makeTrack(std::string_view t, size_t s) { return Track{getTitles(), t, s}; }
 
-    void pushLast(const Track & track) { seconds += track.getValue(); sides[size()-1].push(track); }
+    void clear(void) { seconds = 0; hash = 0; sides.clear(); }
+
+    void pushLast(const Track & track);
     // const Side & operator[](size_t index) const { return sides[index]; }
 
 private:
-    std::string title;
+    std::pmr::string title;
     size_t seconds;
     size_t hash;
-    std::vector<Side> sides;
+    std::pmr::vector<Side> sides;
+
+    // Shared by copies of the album, so the track titles outlive them all.
+    std::shared_ptr<Titles> titles;
 
 };
 
@@ -24,59 +24,219 @@
 #if !defined(_TEXTFILE_H__20210503_1300__INCLUDED_)
 #define _TEXTFILE_H__20210503_1300__INCLUDED_
 
-#include <list>
+#include <vector>
 #include <string>
+#include <string_view>
+#include <span>
+#include <memory>
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/**
+ * @section read only memory mapping of a file.
+ *
+ */
+
+class Mapping
+{
+public:
+    Mapping(const void * p, size_t len) : address{p}, length{len} {}
+    ~Mapping(void) { if (address) munmap(const_cast<void *>(address), length); }
+
+    Mapping(const Mapping &) = delete;
+    void operator=(const Mapping &) = delete;
+
+    const void * data(void) const { return address; }
+    size_t size(void) const { return length; }
+
+private:
+    const void * address;
+    const size_t length;
+
+};
+
+
+/**
+ * @section line terminator scanning.
+ *
+ * Finds the first CR, LF or NUL in a block of bytes, comparing 32 bytes at a
+ * time with AVX2 if the processor has it, checked at run time unless the
+ * build targets AVX2, then 16 at a time with SSE2 (always available on
+ * x86-64), otherwise a byte at a time.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define _TEXTFILE_AVX2_
+
+/**
+ * @brief Scan whole 32 byte blocks for a terminator with AVX2.
+ * 
+ * @param first byte to scan, advanced to the terminator if found, otherwise
+ * to the start of the final partial block.
+ * @param last byte, one past the end.
+ * @return true if a terminator was found.
+ */
+[[gnu::target("avx2")]] inline bool findTerminatorAvx2(const char * & first, const char * last)
+{
+    const __m256i cr{_mm256_set1_epi8('\r')};
+    const __m256i lf{_mm256_set1_epi8('\n')};
+    const __m256i nul{_mm256_setzero_si256()};
+    for (; last - first >= 32; first += 32)
+    {
+        const __m256i block{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(first))};
+        const __m256i found{_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, cr),
+            _mm256_cmpeq_epi8(block, lf)), _mm256_cmpeq_epi8(block, nul))};
+        const uint32_t mask{static_cast<uint32_t>(_mm256_movemask_epi8(found))};
+        if (mask)
+        {
+            first += std::countr_zero(mask);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline bool hasAvx2(void)
+{
+#if defined(__AVX2__)
+    return true;
+#else
+    static const bool avx2{[]() { __builtin_cpu_init(); return __builtin_cpu_supports("avx2") != 0; }()};
+
+    return avx2;
+#endif
+}
+#endif
+
+inline const char * findTerminator(const char * first, const char * last)
+{
+#if defined(_TEXTFILE_AVX2_)
+    if ((last - first >= 32) && hasAvx2() && findTerminatorAvx2(first, last))
+        return first;
+#endif
+
+#if defined(__SSE2__)
+    const __m128i cr{_mm_set1_epi8('\r')};
+    const __m128i lf{_mm_set1_epi8('\n')};
+    const __m128i nul{_mm_setzero_si128()};
+    for (; last - first >= 16; first += 16)
+    {
+        const __m128i block{_mm_loadu_si128(reinterpret_cast<const __m128i *>(first))};
+        const __m128i found{_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, cr),
+            _mm_cmpeq_epi8(block, lf)), _mm_cmpeq_epi8(block, nul))};
+        const uint32_t mask{static_cast<uint32_t>(_mm_movemask_epi8(found))};
+        if (mask)
+            return first + std::countr_zero(mask);
+    }
+#endif
+
+    return std::find_if(first, last, [](char c) { return (c == '\r') || (c == '\n') || (c == '\0'); });
+}
+
+
+/**
+ * @section first difference found by comparing files.
+ *
+ */
+
+template<typename T=char>
+struct Difference
+{
+    bool found{};                   // true if the files differ.
+    size_t expectedLine{};          // Line number, or 0 if the file ended.
+    size_t actualLine{};            // Line number, or 0 if the file ended.
+    std::basic_string<T> expected{};
+    std::basic_string<T> actual{};
+};
 
 
 /**
  * @section text file read/write handling interface.
  *
+ * The lines are held contiguously in a single character buffer (or in the
+ * memory mapped file) and indexed by views into that buffer.
  */
 
 template<typename T=char>
 class TextFile
 {
 public:
-    using Iterator = std::list<std::basic_string<T>>::const_iterator;
+    using View = std::basic_string_view<T>;
+    using Iterator = std::vector<View>::const_iterator;
 
     TextFile(const std::string & file) : fileName{file} {}
     TextFile(const std::filesystem::path & file) : fileName{file} {}
     virtual ~TextFile(void) {}
 
-    TextFile(const TextFile & other) : fileName{other.fileName}, data{other.data} {}
-    void operator=(const TextFile & other) { fileName = other.fileName; data = other.data; }
+    TextFile(const TextFile & other) : fileName{other.fileName} { copy(other); }
+    TextFile(TextFile && other) noexcept = default;
+    void operator=(const TextFile & other) { if (this != &other) { fileName = other.fileName; copy(other); } }
+    TextFile & operator=(TextFile && other) noexcept = default;
 
     friend std::ostream & operator<<(std::ostream &os, const TextFile &A) { A.display(os); return os; }
 
-    void setData(const std::list<std::basic_string<T>> & other) { data = other; }
-    std::list<std::basic_string<T>> getData() { return data; }
-    const std::list<std::basic_string<T>> getData() const { return data; }
-    std::list<std::basic_string<T>> moveData() noexcept { return std::move(data); }
-    void moveData(std::list<std::basic_string<T>> && other) noexcept { data = std::move(other); }
+    template<typename R>
+    void setData(const R & other) { clear(); for (const auto & line : other) push_back(line); }
+    std::span<const View> getData() const { return lines; }
+    View getBuffer(void) const { return mapping ? View{static_cast<const T *>(mapping->data()), mapping->size()} : View{buffer.data(), buffer.size()}; }
+    void push_back(View line);
 
     bool equal(const TextFile & other) const;
-    bool equal(const TextFile & other, size_t count) const { return std::equal(data.begin(), data.begin()+count, other.data.begin()); }
-    void clear(void) { data.clear(); }
+    bool equal(const TextFile & other, size_t count) const;
+    void clear(void) { lines.clear(); buffer.clear(); mapping.reset(); }
 
     void setFileName(const std::string & file) { fileName = file; }
     void setFileName(const std::filesystem::path & file) { fileName = file; }
     std::string getFileName(void) const { return fileName.c_str(); }
     bool exists(void) const { return std::filesystem::exists(fileName); }
 
-    void reserve(size_t size) { data.reserve(size); }
-    size_t size(void) { return data.size(); }
-    Iterator begin(void) { return data.begin(); }
-    Iterator end(void) { return data.end(); }
+    void reserve(size_t size, size_t chars = 0) { lines.reserve(size); if (chars) { detach(); reserveBuffer(chars); } }
+    size_t size(void) const { return lines.size(); }
+    View operator[](size_t index) const { return lines[index]; }
+    Iterator begin(void) const { return lines.begin(); }
+    Iterator end(void) const { return lines.end(); }
 
-    int write(const std::list<std::basic_string<T>> & other) { setData(other); return write(); }
+    template<typename R>
+    int write(const R & other) { setData(other); return write(); }
     int write(void) const;
     int read(void);
+    int read(std::basic_istream<T> & is);
+
+    int map(void) requires (sizeof(T) == 1);
+
+    class Cursor;
+    Cursor cursor(size_t size = blockSize) const { return Cursor{fileName, size}; }
+
+    static View trim(View line);
+    static const T * scan(const T * first, const T * last);
+
+    static constexpr size_t blockSize{64 * 1024};
 
 private:
     std::filesystem::path fileName;
-    std::list<std::basic_string<T>> data;
+    std::vector<T> buffer;
+    std::vector<View> lines;
+
+    std::shared_ptr<const Mapping> mapping;
+
+    void copy(const TextFile & other);
+    void detach(void);
+    void reserveBuffer(size_t chars);
+    void index(size_t start);
 
 };
 
@@ -86,6 +246,165 @@ private:
  *
  */
 
+/**
+ * @brief Copy the lines of the supplied TextFile. A mapping is shared, owned
+ * lines are copied and re-indexed against the copied buffer.
+ * 
+ * @tparam T Char type.
+ * @param other the TextFile to copy.
+ */
+template<typename T>
+void TextFile<T>::copy(const TextFile & other)
+{
+    mapping = other.mapping;
+    buffer = other.buffer;
+    lines = other.lines;
+    if (mapping)
+        return;
+
+    const T * base{other.buffer.data()};
+    for (auto & line : lines)
+        line = View{buffer.data() + (line.data() - base), line.size()};
+}
+
+/**
+ * @brief Move the lines of a memory mapped file into the buffer so that more
+ * lines can be added.
+ * 
+ * @tparam T Char type.
+ */
+template<typename T>
+void TextFile<T>::detach(void)
+{
+    if (!mapping)
+        return;
+
+    const auto keep{mapping};
+    std::vector<View> mapped{};
+    mapped.swap(lines);
+    mapping.reset();
+
+    size_t chars{};
+    for (const auto & line : mapped)
+        chars += line.size();
+    reserveBuffer(chars);
+
+    for (const auto & line : mapped)
+        push_back(line);
+}
+
+/**
+ * @brief Grow the buffer, re-indexing the lines if it moves.
+ * 
+ * @tparam T Char type.
+ * @param chars total number of characters required.
+ */
+template<typename T>
+void TextFile<T>::reserveBuffer(size_t chars)
+{
+    const T * base{buffer.data()};
+    buffer.reserve(chars);
+    if (buffer.data() == base)
+        return;
+
+    for (auto & line : lines)
+        line = View{buffer.data() + (line.data() - base), line.size()};
+}
+
+/**
+ * @brief Append a line to the buffer.
+ * 
+ * @tparam T Char type.
+ * @param line to append.
+ */
+template<typename T>
+void TextFile<T>::push_back(View line)
+{
+    // Keep any mapping alive in case the line is held in it.
+    const auto keep{mapping};
+    detach();
+
+    const size_t start{buffer.size()};
+    const size_t length{line.size()};
+    if (start + length > buffer.capacity())
+    {
+        // Copy first in case the line is held in the buffer being moved.
+        std::vector<T> text(line.begin(), line.end());
+        reserveBuffer(std::max(start + length, 2 * buffer.capacity()));
+        buffer.insert(buffer.end(), text.begin(), text.end());
+    }
+    else
+        buffer.insert(buffer.end(), line.begin(), line.end());
+
+    lines.emplace_back(buffer.data() + start, length);
+}
+
+/**
+ * @brief Index the lines in the buffer from start onwards, in a single pass
+ * that scans for the line terminators. Each line is truncated at the first
+ * CR, LF or NUL, empty lines are skipped and a last line without a
+ * terminating newline is ignored.
+ * 
+ * @tparam T Char type.
+ * @param start offset into the buffer of the first line to index.
+ */
+template<typename T>
+void TextFile<T>::index(size_t start)
+{
+    const View text{getBuffer()};
+    const T * const last{text.data() + text.size()};
+    for (const T * first{text.data() + start}; first != last; )
+    {
+        const T * const end{scan(first, last)};
+        if (end == last)
+            break;
+
+        // A CR or NUL ends the line early, so skip on to the newline.
+        const T * const newline{*end == T('\n') ? end : std::find(end, last, T('\n'))};
+        if (newline == last)
+            break;
+
+        if (end != first)
+            lines.emplace_back(first, end - first);
+        first = newline + 1;
+    }
+}
+
+/**
+ * @brief Truncate a line at the first CR, LF or NUL.
+ * 
+ * @tparam T Char type.
+ * @param line to truncate.
+ * @return View the truncated line.
+ */
+template<typename T>
+TextFile<T>::View TextFile<T>::trim(View line)
+{
+    return line.substr(0, scan(line.data(), line.data() + line.size()) - line.data());
+}
+
+/**
+ * @brief Find the first CR, LF or NUL, using findTerminator() for single
+ * byte characters and a simple search for any other character type.
+ * 
+ * @tparam T Char type.
+ * @param first character to search.
+ * @param last end of the characters to search.
+ * @return const T* the first terminator, or last if there is none.
+ */
+template<typename T>
+const T * TextFile<T>::scan(const T * first, const T * last)
+{
+    if constexpr (sizeof(T) == 1)
+    {
+        const char * const begin{reinterpret_cast<const char *>(first)};
+
+        return first + (findTerminator(begin, reinterpret_cast<const char *>(last)) - begin);
+    }
+    else
+        return std::find_if(first, last, [](T c) { return (c == T('\r')) || (c == T('\n')) || (c == T('\0')); });
+}
+
 /**
  * @brief Compares the data of the supplied TextFile equals this data.
  * 
@@ -97,10 +416,29 @@ private:
 template<typename T>
 bool TextFile<T>::equal(const TextFile & other) const
 {
-    if (data.size() != other.data.size())
+    if (lines.size() != other.lines.size())
+        return false;
+
+    return std::equal(lines.begin(), lines.end(), other.lines.begin());
+}
+
+/**
+ * @brief Compares the first count lines of the supplied TextFile with this
+ * data.
+ * 
+ * @tparam T Char type.
+ * @param other the suplied TextFile to compare.
+ * @param count the number of lines to compare.
+ * @return true if both have at least count lines and they are equal.
+ * @return false otherwise.
+ */
+template<typename T>
+bool TextFile<T>::equal(const TextFile & other, size_t count) const
+{
+    if ((lines.size() < count) || (other.lines.size() < count))
         return false;
 
-    return std::equal(data.begin(), data.end(), other.data.begin());
+    return std::equal(lines.begin(), lines.begin()+count, other.lines.begin());
 }
 
 
@@ -115,7 +453,7 @@ int TextFile<T>::write(void) const
 {
     if (std::basic_ofstream<T> os{fileName, std::ios::out})
     {
-        for (const auto & line : data)
+        for (const auto & line : lines)
             os << line << '\n';
 
         return 0;
@@ -129,32 +467,278 @@ int TextFile<T>::write(void) const
  * @brief Read the named file into the buffer.
  * 
  * @tparam T Char type.
- * @param res reserve the number of lines in the buffer.
  * @return int error value or 0 if no errors.
  */
 template<typename T>
 int TextFile<T>::read(void)
 {
-    const std::basic_string<T> tokens{T('\r'), T('\n'), T('\0')};
     if (std::basic_ifstream<T> is{fileName, std::ios::in})
+        return read(is);
+
+    return 1;
+}
+
+
+/**
+ * @brief Read the supplied stream into the buffer, in large blocks, then
+ * index the lines.
+ * 
+ * @tparam T Char type.
+ * @param is the stream to read.
+ * @return int error value or 0 if no errors.
+ */
+template<typename T>
+int TextFile<T>::read(std::basic_istream<T> & is)
+{
+    detach();
+
+    const size_t start{buffer.size()};
+    for (;;)
+    {
+        const size_t size{buffer.size()};
+        if (size + blockSize > buffer.capacity())
+            reserveBuffer(std::max(size + blockSize, 2 * buffer.capacity()));
+
+        buffer.resize(size + blockSize);
+        is.read(buffer.data() + size, blockSize);
+        buffer.resize(size + is.gcount());
+        if (!is)
+            break;
+    }
+
+    index(start);
+
+    return 0;
+}
+
+
+/**
+ * @brief Memory map the named file and index the lines as views into the
+ * mapping, applying the same rules as read(). Any existing lines are
+ * replaced. The mapping is shared with copies and is released by clear() or
+ * when the last copy is destroyed.
+ * 
+ * @tparam T Char type, which must be a single byte.
+ * @return int error value or 0 if no errors.
+ */
+template<typename T>
+int TextFile<T>::map(void) requires (sizeof(T) == 1)
+{
+    clear();
+
+    const int fd{open(fileName.c_str(), O_RDONLY)};
+    if (fd == -1)
+        return 1;
+
+    struct stat status;
+    if (fstat(fd, &status) == -1)
     {
-        std::basic_string<T> line;
+        close(fd);
+        return 1;
+    }
+
+    const size_t length{static_cast<size_t>(status.st_size)};
+    if (length == 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    void * address{mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0)};
+    close(fd);
+    if (address == MAP_FAILED)
+        return 1;
+
+    madvise(address, length, MADV_SEQUENTIAL);
+    mapping = std::make_shared<const Mapping>(address, length);
+    index(0);
+
+    return 0;
+}
+
+
+/**
+ * @section streaming line cursor interface.
+ *
+ * Reads a file (or stream) through a fixed size buffer, yielding one line at
+ * a time with the same rules as read(). A line is only valid until the next
+ * call to next(). The buffer only grows if a single line is larger than it.
+ */
+
+template<typename T>
+class TextFile<T>::Cursor
+{
+public:
+    Cursor(const std::filesystem::path & file, size_t size);
+    Cursor(std::basic_istream<T> & stream, size_t size = blockSize) : is{&stream}, buffer(size) {}
+    Cursor(View text) : is{}, window{text}, eof{true} {}
+
+    bool isOpen(void) const { return is || eof; }
+    bool next(View & line);
+    size_t skip(Cursor & other);
+    Difference<T> compare(Cursor & actual);
+    size_t getLineNumber(void) const { return number; }
+
+private:
+    std::unique_ptr<std::basic_ifstream<T>> file;
+    std::basic_istream<T> * is;
+    std::vector<T> buffer;
+    View window{};
+    bool eof{};
+    size_t number{};
+
+    bool fill(void);
+
+};
+
+
+/**
+ * @section streaming line cursor implementation.
+ *
+ */
+
+/**
+ * @brief Construct a cursor that reads the named file. If the file can't be
+ * opened, isOpen() returns false and there are no lines.
+ * 
+ * @tparam T Char type.
+ * @param fileName of the file to read.
+ * @param size of the read buffer.
+ */
+template<typename T>
+TextFile<T>::Cursor::Cursor(const std::filesystem::path & fileName, size_t size)
+    : file{std::make_unique<std::basic_ifstream<T>>(fileName, std::ios::in)}, is{}, buffer(size)
+{
+    if (*file)
+        is = file.get();
+    else
+        file.reset();
+}
+
+/**
+ * @brief Move any partial line to the front of the buffer and read more.
+ * 
+ * @tparam T Char type.
+ * @return true if more characters were read, false at end of stream.
+ */
+template<typename T>
+bool TextFile<T>::Cursor::fill(void)
+{
+    if (eof || !is)
+        return false;
+
+    // A full buffer holds a single partial line, so grow it.
+    const size_t kept{window.size()};
+    if (kept == buffer.size())
+        buffer.resize(2 * std::max(kept, size_t{1}));
+    else if (kept)
+        std::char_traits<T>::move(buffer.data(), window.data(), kept);
+
+    is->read(buffer.data() + kept, buffer.size() - kept);
+    const size_t count{static_cast<size_t>(is->gcount())};
+    eof = !*is;
+    window = View{buffer.data(), kept + count};
+
+    return count != 0;
+}
 
-        while (getline(is, line))
+/**
+ * @brief Get the next non-empty line. As with read(), a last line without a
+ * terminating newline is ignored.
+ * 
+ * @tparam T Char type.
+ * @param line set to the next line, valid until the next call.
+ * @return true if a line was found, false at the end of the file.
+ */
+template<typename T>
+bool TextFile<T>::Cursor::next(View & line)
+{
+    for (;;)
+    {
+        // A CR or NUL ends the line early, so skip on to the newline.
+        const size_t end{static_cast<size_t>(scan(window.data(), window.data() + window.size()) - window.data())};
+        const size_t newline{(end < window.size()) && (window[end] == T('\n')) ? end : window.find(T('\n'), end)};
+        if (newline == View::npos)
         {
-            const auto pos{line.find_first_of(tokens)};
-            if (pos != std::basic_string<T>::npos)
-                line = line.substr(0, pos);
-            if (!is.eof() && line.length())
-                data.push_back(std::move(line));
+            if (fill())
+                continue;
+
+            return false;
         }
 
-        return 0;
+        ++number;
+        line = window.substr(0, end);
+        window.remove_prefix(newline + 1);
+        if (line.length())
+            return true;
     }
+}
 
-    return 1;
+/**
+ * @brief Skip the lines at the start of both cursors that are identical,
+ * byte for byte, within the currently buffered text. Identical text yields
+ * identical lines, so they do not need to be split and compared one by one.
+ * 
+ * @tparam T Char type.
+ * @param other cursor to skip alongside this one.
+ * @return size_t the number of lines skipped.
+ */
+template<typename T>
+size_t TextFile<T>::Cursor::skip(Cursor & other)
+{
+    // Compare in chunks, which the library does a block at a time.
+    const size_t length{std::min(window.size(), other.window.size())};
+    const size_t chunk{256};
+    size_t same{};
+    while ((same + chunk <= length) && (std::char_traits<T>::compare(window.data() + same, other.window.data() + same, chunk) == 0))
+        same += chunk;
+    while ((same < length) && (window[same] == other.window[same]))
+        ++same;
+
+    const size_t end{window.substr(0, same).rfind(T('\n'))};
+    if (end == View::npos)
+        return 0;
+
+    const View text{window.substr(0, end + 1)};
+    const size_t count{static_cast<size_t>(std::count(text.begin(), text.end(), T('\n')))};
+    window.remove_prefix(text.size());
+    other.window.remove_prefix(text.size());
+    number += count;
+    other.number += count;
+
+    return count;
 }
 
 
-#endif // !defined(_TEXTFILE_H__20210503_1300__INCLUDED_)
+/**
+ * @brief Walk this cursor and another together, a block at a time, and stop
+ * at the first line that differs. Lines are compared with the same rules as
+ * equal() after read(), so line endings and empty lines are not significant.
+ * 
+ * @tparam T Char type.
+ * @param actual cursor over the text to check against this expected text.
+ * @return Difference the first differing lines, if any.
+ */
+template<typename T>
+Difference<T> TextFile<T>::Cursor::compare(Cursor & actual)
+{
+    for (;;)
+    {
+        skip(actual);
+
+        View lhs{};
+        View rhs{};
+        const bool more{next(lhs)};
+        const bool others{actual.next(rhs)};
+        if (!more && !others)
+            return {};
+
+        if ((more != others) || (lhs != rhs))
+            return Difference<T>{true,
+                more ? getLineNumber() : 0, others ? actual.getLineNumber() : 0,
+                std::basic_string<T>{lhs}, std::basic_string<T>{rhs}};
+    }
+}
 
+
+#endif // !defined(_TEXTFILE_H__20210503_1300__INCLUDED_)
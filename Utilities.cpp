@@ -24,6 +24,9 @@
  * Basic utility code for the Balancer.
  */
 
+#include <algorithm>
+#include <charconv>
+
 #include "Utilities.h"
 #include "TextFile.h"
 
@@ -38,32 +41,54 @@ const std::string digit{"0123456789"};
 
 /**
  * @brief Break a time string (H:M:S) down to get total number of seconds.
- * Also handles M:S and S formats.
+ * Also handles M:S and S formats. Any non-digit characters separate the
+ * fields and there is no allocation, locale dependence or exception.
  * 
  * @param buffer time string to parse.
  * @return size_t the equivalent number of seconds.
  */
-size_t timeStringToSeconds(std::string buffer)
+size_t timeStringToSeconds(std::string_view buffer)
 {
-    size_t digits{};
     size_t seconds{};
-    size_t pos{};
+    const char * pos{buffer.data()};
+    const char * const end{pos + buffer.size()};
+    auto isDigit{[](char c) { return (c >= '0') && (c <= '9'); }};
 
     for (int i = 0; i < 3; ++i)
     {
-        buffer = buffer.substr(digits);
-        pos = buffer.find_first_of(digit);
-        if (pos == std::string::npos)
+        pos = std::find_if(pos, end, isDigit);
+        if (pos == end)
+            break;
+
+        size_t value{};
+        const auto [next, error]{std::from_chars(pos, end, value)};
+        if (error != std::errc{})
             break;
 
-        seconds *= 60;
-        buffer = buffer.substr(pos);
-        seconds += std::stoi(buffer, &digits);
+        seconds = seconds * 60 + value;
+        pos = next;
     }
 
     return seconds;
 }
 
+/**
+ * @brief Convert a column of time strings to seconds in one pass.
+ * 
+ * @param buffers time strings to parse.
+ * @param seconds receives the equivalent number of seconds for each.
+ * @return size_t the number of time strings converted, limited by the
+ * smaller of the two spans.
+ */
+size_t timeStringsToSeconds(std::span<const std::string_view> buffers, std::span<size_t> seconds)
+{
+    const size_t count{std::min(buffers.size(), seconds.size())};
+    for (size_t i = 0; i < count; ++i)
+        seconds[i] = timeStringToSeconds(buffers[i]);
+
+    return count;
+}
+
 
 /**
  * @brief Generates a time string in the form H:M:S from the given seconds.
@@ -74,23 +99,91 @@ size_t timeStringToSeconds(std::string buffer)
  */
 std::string secondsToTimeString(size_t seconds, const std::string & sep)
 {
-    std::ostringstream ss;
+    TimeBuffer buffer;
+    if (sep.length() == 1)
+        return std::string{secondsToTimeString(seconds, buffer, sep[0])};
+
+    std::string time{secondsToTimeString(seconds, buffer, ':')};
+    const size_t pos{time.find(':')};
+    time.replace(pos + 3, 1, sep);
+    time.replace(pos, 1, sep);
 
-    size_t hours{seconds / 3600};
+    return time;
+}
+
+/**
+ * @brief Two digit strings for 00 to 99, to convert a pair of digits at a
+ * time.
+ */
+static constexpr auto digitPairs{[]()
+{
+    std::array<char, 200> pairs{};
+    for (int i = 0; i < 100; ++i)
+    {
+        pairs[2*i] = char('0' + i / 10);
+        pairs[2*i+1] = char('0' + i % 10);
+    }
+
+    return pairs;
+}()};
+
+static char * writePair(char * pos, size_t value)
+{
+    *pos++ = digitPairs[2*value];
+    *pos++ = digitPairs[2*value+1];
+
+    return pos;
+}
+
+/**
+ * @brief Generates a time string in the form H:M:S from the given seconds
+ * into the supplied buffer, without allocation.
+ * 
+ * @param seconds number of seconds to represent.
+ * @param buffer to hold the time string.
+ * @param sep optional seperator or ':' if none specified.
+ * @return std::string_view time string in the form H:M:S, valid for the
+ * lifetime of the buffer.
+ */
+std::string_view secondsToTimeString(size_t seconds, TimeBuffer & buffer, char sep)
+{
+    const size_t hours{seconds / 3600};
     seconds -= hours * 3600;
 
-    size_t minutes{seconds / 60};
+    const size_t minutes{seconds / 60};
     seconds -= minutes * 60;
 
-    ss.width(2);
-    ss.fill('0');
-    ss << hours << sep;
-    ss.width(2);
-    ss << minutes << sep;
-    ss.width(2);
-    ss << seconds;
+    char * pos{buffer.data()};
+    if (hours < 100)
+        pos = writePair(pos, hours);
+    else
+        pos = std::to_chars(pos, buffer.data() + buffer.size(), hours).ptr;
+
+    *pos++ = sep;
+    pos = writePair(pos, minutes);
+    *pos++ = sep;
+    pos = writePair(pos, seconds);
+
+    return std::string_view{buffer.data(), static_cast<size_t>(pos - buffer.data())};
+}
+
+/**
+ * @brief Generates either a plain number of seconds or a time string in the
+ * form H:M:S into the supplied buffer, without allocation.
+ * 
+ * @param seconds number of seconds to represent.
+ * @param buffer to hold the string.
+ * @param plain true for a plain number of seconds.
+ * @return std::string_view the string, valid for the lifetime of the buffer.
+ */
+std::string_view secondsToString(size_t seconds, TimeBuffer & buffer, bool plain)
+{
+    if (!plain)
+        return secondsToTimeString(seconds, buffer);
+
+    const auto end{std::to_chars(buffer.data(), buffer.data() + buffer.size(), seconds).ptr};
 
-    return ss.str();
+    return std::string_view{buffer.data(), static_cast<size_t>(end - buffer.data())};
 }
 
 
@@ -106,7 +199,7 @@ std::string secondsToTimeString(size_t seconds, const std::string & sep)
  * @param items maximum number of items.
  * @return std::vector<std::string> 
  */
-std::vector<std::string> split(const std::string & line, size_t items)
+std::vector<std::string> split(std::string_view line, size_t items)
 {
     size_t start{};
     size_t end = line.find(iSep, start);
@@ -125,4 +218,51 @@ std::vector<std::string> split(const std::string & line, size_t items)
     return list;
 }
 
+/**
+ * @brief Split a line (a maximum of items.size() times), delimited by '|'
+ * into views of the line, without allocation. A field starting with a
+ * double quote ends at the closing quote, may contain the delimiter and has
+ * the quotes removed. The last item takes the rest of the line, with any
+ * enclosing quotes removed.
+ * 
+ * @param line to be split.
+ * @param items receives the fields, which are views into line.
+ * @return size_t the number of fields found.
+ */
+size_t split(std::string_view line, std::span<std::string_view> items)
+{
+    const size_t count{items.size()};
+    size_t found{};
+    size_t start{};
+    while (found < count)
+    {
+        std::string_view rest{line.substr(start)};
+        if (found + 1 == count)
+        {
+            if ((rest.length() >= 2) && (rest.front() == '"') && (rest.back() == '"'))
+                rest = rest.substr(1, rest.length() - 2);
+            items[found++] = rest;
+            break;
+        }
 
+        size_t end{};
+        if (rest.starts_with('"'))
+        {
+            const size_t quote{rest.find('"', 1)};
+            items[found++] = rest.substr(1, quote == std::string_view::npos ? std::string_view::npos : quote - 1);
+            end = rest.find(iSep, quote == std::string_view::npos ? rest.length() : quote);
+        }
+        else
+        {
+            end = rest.find(iSep);
+            items[found++] = rest.substr(0, end);
+        }
+
+        if (end == std::string_view::npos)
+            break;
+
+        start += end + 1;
+    }
+
+    return found;
+}
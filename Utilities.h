@@ -27,7 +27,12 @@
 #if !defined _UTILITIES_H_INCLUDED_
 #define _UTILITIES_H_INCLUDED_
 
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <span>
 #include <vector>
 
 
@@ -43,13 +48,56 @@ extern const std::string digit;
 const char iSep{'|'};   // Input field seperator.
 const char oSep{'|'};   // Output field seperator.
 
-extern size_t timeStringToSeconds(std::string buffer);
+extern size_t timeStringToSeconds(std::string_view buffer);
+extern size_t timeStringsToSeconds(std::span<const std::string_view> buffers, std::span<size_t> seconds);
+using TimeBuffer = std::array<char, 32>;
+
+const uint64_t splitMixGamma{0x9e3779b97f4a7c15};
+
+/**
+ * @brief Mix the bits of a value (splitmix64), for well mixed hashes and
+ * seeded random numbers.
+ */
+inline uint64_t splitMix64(uint64_t value)
+{
+    value += splitMixGamma;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+
+    return value ^ (value >> 31);
+}
+
 extern std::string secondsToTimeString(size_t seconds, const std::string & sep = ":");
+extern std::string_view secondsToTimeString(size_t seconds, TimeBuffer & buffer, char sep = ':');
+extern std::string_view secondsToString(size_t seconds, TimeBuffer & buffer, bool plain);
 
 
 ///////////////////////////////////////////////////////////////////////////////
 
-extern std::vector<std::string> split(const std::string & line, size_t items);
+extern std::vector<std::string> split(std::string_view line, size_t items);
+extern size_t split(std::string_view line, std::span<std::string_view> items);
+
+/**
+ * @brief Parse the whole of a value, such as a command line option, as a
+ * number, without throwing.
+ * 
+ * @tparam T the type of number.
+ * @param text of the option value.
+ * @param value set if the text is a valid number.
+ * @return true if the text is a valid number.
+ */
+template<typename T>
+bool parseValue(std::string_view text, T & value)
+{
+    T parsed{};
+    const auto [end, ec]{std::from_chars(text.data(), text.data() + text.size(), parsed)};
+    if ((ec != std::errc{}) || (end != text.data() + text.size()))
+        return false;
+
+    value = parsed;
+
+    return true;
+}
 
 
 #endif //!defined _UTILITIES_H_INCLUDED_
@@ -0,0 +1,133 @@
+/**
+ * @file    Validator.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Order insensitive validation of a balanced album against its input tracks,
+ * and measures of how well the sides are balanced.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+#include "Validator.h"
+
+
+/**
+ * @section Support code.
+ *
+ */
+
+/**
+ * @brief A track identified by its title and duration, to count the copies
+ * of each track in a hash map.
+ */
+struct Key
+{
+    std::string_view title;
+    size_t seconds;
+
+    bool operator==(const Key &) const = default;
+};
+
+struct KeyHash
+{
+    size_t operator()(const Key & key) const
+    {
+        return std::hash<std::string_view>{}(key.title) ^ (key.seconds * 0x9e3779b97f4a7c15);
+    }
+};
+
+
+/**
+ * @section result validation.
+ *
+ */
+
+/**
+ * @brief Determine if the album holds exactly the given tracks, in any order
+ * and on any side, by counting the copies of each title and duration. This
+ * takes linear time, however the tracks are arranged.
+ *
+ * @param tracks the input tracks.
+ * @param album the balanced album.
+ * @return true if the album is a permutation of the tracks, false otherwise.
+ */
+bool isPermutation(const std::vector<Track> & tracks, const Album & album)
+{
+    size_t count{};
+    for (const auto & side : album)
+        count += side.size();
+
+    if (count != tracks.size())
+        return false;
+
+    std::unordered_map<Key, size_t, KeyHash> counts{};
+    counts.reserve(tracks.size());
+    for (const auto & track : tracks)
+        ++counts[Key{track.getTitle(), track.getValue()}];
+
+    // With equal sizes, no track can be left over if none is missing.
+    for (const auto & side : album)
+        for (const auto & track : side)
+        {
+            const auto it{counts.find(Key{track.getTitle(), track.getValue()})};
+            if ((it == counts.end()) || (it->second == 0))
+                return false;
+
+            --it->second;
+        }
+
+    return true;
+}
+
+/**
+ * @brief Measure how evenly the tracks are balanced across the sides of the
+ * album.
+ *
+ * @param album the balanced album.
+ * @return Quality the balance measures, all zero for an empty album.
+ */
+Quality measureQuality(const Album & album)
+{
+    Quality quality{};
+    if (album.size() == 0)
+        return quality;
+
+    quality.shortest = album.begin()->getValue();
+    for (const auto & side : album)
+    {
+        quality.longest = std::max(quality.longest, side.getValue());
+        quality.shortest = std::min(quality.shortest, side.getValue());
+    }
+    quality.spread = quality.longest - quality.shortest;
+    quality.ideal = static_cast<double>(album.getValue()) / album.size();
+
+    for (const auto & side : album)
+    {
+        const double difference{side.getValue() - quality.ideal};
+        quality.variance += difference * difference;
+    }
+    quality.variance /= album.size();
+
+    return quality;
+}
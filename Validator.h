@@ -0,0 +1,60 @@
+/**
+ * @file    Validator.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Order insensitive validation of a balanced album against its input tracks,
+ * and measures of how well the sides are balanced.
+ */
+
+#if !defined _VALIDATOR_H_INCLUDED_
+#define _VALIDATOR_H_INCLUDED_
+
+#include <vector>
+
+#include "Side.h"
+
+
+/**
+ * @section Define balance quality.
+ *
+ */
+
+struct Quality
+{
+    size_t longest{};       // Longest side in seconds.
+    size_t shortest{};      // Shortest side in seconds.
+    size_t spread{};        // Longest less shortest side.
+    double ideal{};         // Mean side duration, the ideal for every side.
+    double variance{};      // Mean squared difference of the sides from the ideal.
+};
+
+
+/**
+ * @section result validation.
+ *
+ */
+
+extern bool isPermutation(const std::vector<Track> & tracks, const Album & album);
+extern Quality measureQuality(const Album & album);
+
+
+#endif //!defined _VALIDATOR_H_INCLUDED_
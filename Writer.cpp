@@ -0,0 +1,106 @@
+/**
+ * @file    Writer.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Buffered output, formatting everything into one growable buffer so that
+ * it can be written to the sink in a single call.
+ */
+
+#include <cerrno>
+#include <charconv>
+#include <unistd.h>
+
+#include "Writer.h"
+#include "Utilities.h"
+
+
+/**
+ * @section Define Writer class.
+ *
+ */
+
+/**
+ * @brief Append a number in decimal.
+ * 
+ * @param value to append.
+ * @return Writer& this writer.
+ */
+Writer & Writer::appendNumber(size_t value)
+{
+    char digits[24];
+    const auto end{std::to_chars(digits, digits + sizeof(digits), value).ptr};
+
+    return append(std::string_view{digits, static_cast<size_t>(end - digits)});
+}
+
+/**
+ * @brief Append a duration, either as H:M:S or as a plain number of seconds.
+ * 
+ * @param seconds duration to append.
+ * @param plain true for a plain number of seconds.
+ * @return Writer& this writer.
+ */
+Writer & Writer::appendTime(size_t seconds, bool plain)
+{
+    TimeBuffer time;
+
+    return append(secondsToString(seconds, time, plain));
+}
+
+/**
+ * @brief Write the buffer to a file descriptor. A single write() is enough
+ * unless the descriptor accepts only part of the buffer, e.g. a full pipe.
+ * 
+ * @param fd file descriptor to write to.
+ * @return true if the whole buffer was written, false otherwise.
+ */
+bool Writer::write(int fd) const
+{
+    const char * data{buffer.data()};
+    size_t remaining{buffer.size()};
+    while (remaining)
+    {
+        const ssize_t count{::write(fd, data, remaining)};
+        if (count > 0)
+        {
+            data += count;
+            remaining -= count;
+        }
+        else if ((count == 0) || (errno != EINTR))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Write the buffer to a stream in a single call.
+ * 
+ * @param os output stream.
+ * @return true if the stream is still good, false otherwise.
+ */
+bool Writer::write(std::ostream & os) const
+{
+    os.write(buffer.data(), buffer.size());
+
+    return os.good();
+}
@@ -0,0 +1,67 @@
+/**
+ * @file    Writer.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * 'Balancer' is a command-line utility for balancing 'tracks' across multiple
+ * sides.
+ *
+ * Buffered output, formatting everything into one growable buffer so that
+ * it can be written to the sink in a single call.
+ */
+
+#if !defined _WRITER_H_INCLUDED_
+#define _WRITER_H_INCLUDED_
+
+#include <string>
+#include <string_view>
+#include <ostream>
+
+
+/**
+ * @section Define Writer class.
+ *
+ */
+
+class Writer
+{
+public:
+    Writer(size_t size = defaultSize) : buffer{} { buffer.reserve(size); }
+
+    Writer & append(std::string_view text) { buffer.append(text); return *this; }
+    Writer & append(char c) { buffer.push_back(c); return *this; }
+    Writer & appendNumber(size_t value);
+    Writer & appendTime(size_t seconds, bool plain);
+
+    std::string_view view(void) const { return buffer; }
+    size_t size(void) const { return buffer.size(); }
+    void clear(void) { buffer.clear(); }
+
+    bool write(int fd) const;
+    bool write(std::ostream & os) const;
+
+    // Enough for a track or a summary line, larger output grows the buffer.
+    static constexpr size_t defaultSize{256};
+
+private:
+    std::string buffer;
+
+};
+
+
+#endif //!defined _WRITER_H_INCLUDED_
@@ -0,0 +1,1021 @@
+/**
+ * @file    bench.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmarks for the Balancer test support code.
+ *
+ * Build and run using:
+ *    make bench
+ *
+ * or run only the benchmarks whose names contain a filter using:
+ *    ./bench filter
+ *
+ * Each line reports the time and the number of heap allocations per
+ * operation, and the throughput in MB/s (or millions of operations a second
+ * when no byte count applies), from the median of several runs after a
+ * warm up run.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <sstream>
+#include <set>
+#include <algorithm>
+#include <filesystem>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <memory_resource>
+#include <random>
+#include <array>
+
+#include "Side.h"
+#include "AlbumFile.h"
+
+
+/**
+ * @section Basic utility code.
+ */
+
+static volatile size_t sink{};
+static std::atomic<size_t> allocations{};
+
+/**
+ * @brief Count every heap allocation made through operator new.
+ */
+[[gnu::noinline]] void * operator new(size_t size)
+{
+    ++allocations;
+    if (void * p = std::malloc(size ? size : 1))
+        return p;
+
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void * p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void * p, size_t) noexcept { std::free(p); }
+
+/**
+ * @brief Count the aligned allocations too, as made by the default memory
+ * resource of a polymorphic allocator.
+ */
+[[gnu::noinline]] void * operator new(size_t size, std::align_val_t align)
+{
+    ++allocations;
+    const size_t alignment{static_cast<size_t>(align)};
+    if (void * p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment))
+        return p;
+
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void * p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void * p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+/**
+ * @brief Time a number of operations and report the cost of each. The
+ * function is run once to warm up, then timed over several runs and the
+ * median run is reported.
+ * 
+ * @param name of the benchmark.
+ * @param ops number of operations performed by the function.
+ * @param func the function to time.
+ * @param bytes processed by the function, if throughput applies.
+ * @return double nanoseconds per operation.
+ */
+template<typename F>
+static double measure(const std::string & name, size_t ops, F func, size_t bytes = 0)
+{
+    const size_t runs{5};
+    func();
+
+    std::array<double, runs> times{};
+    const size_t before{allocations};
+    for (auto & time : times)
+    {
+        const auto start{std::chrono::steady_clock::now()};
+        func();
+        const std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now() - start};
+        time = elapsed.count();
+    }
+    const double allocs{static_cast<double>(allocations - before) / (runs * ops)};
+
+    std::nth_element(times.begin(), times.begin() + runs / 2, times.end());
+    const double median{times[runs / 2]};
+    const double perOp{median / ops};
+    std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed;
+    std::cout << std::setw(14) << std::setprecision(1) << perOp << " ns/op";
+    std::cout << std::setw(10) << std::setprecision(2) << allocs << " allocs/op";
+    if (bytes)
+        std::cout << std::setw(10) << std::setprecision(1) << bytes * 1e3 / median << " MB/s\n";
+    else
+        std::cout << std::setw(10) << std::setprecision(1) << ops * 1e3 / median << " Mops/s\n";
+
+    return perOp;
+}
+
+static Side makeSide(size_t count)
+{
+    Side side{};
+    for (size_t i = 0; i < count; ++i)
+        side.push(Track{"Track " + std::to_string(i), 120 + (i * 37) % 300});
+
+    return side;
+}
+
+
+/**
+ * @section Side hash benchmarks.
+ */
+
+/**
+ * @brief The previous Side hash, rebuilt from a multiset on every call.
+ */
+static size_t rebuildHash(const Side & side)
+{
+    size_t hash{side.size()};
+
+    std::multiset<size_t> values{};
+    for (const auto & track : side)
+        values.insert(track.getValue());
+
+    for (const auto & value : values)
+    {
+        hash <<= 1;
+        hash ^= std::hash<size_t>{}(value);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compare the incremental hash with the multiset rebuild when the
+ * hash is checked after every push, as in a backtracking search.
+ */
+static void benchSideHash(void)
+{
+    std::cout << "\nSide push/getHash/pop:\n";
+
+    const Track track{"Extra", 200};
+    for (const size_t count : {8, 32, 128})
+    {
+        Side side{makeSide(count)};
+        const size_t ops{1000000 / count};
+        const std::string suffix{" (" + std::to_string(count) + " tracks)"};
+
+        const double incremental{measure("incremental" + suffix, ops, [&]()
+        {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                side.push(track);
+                sink = sink + side.getHash();
+                side.pop();
+            }
+        })};
+
+        const double rebuild{measure("multiset rebuild" + suffix, ops, [&]()
+        {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                side.push(track);
+                sink = sink + rebuildHash(side);
+                side.pop();
+            }
+        })};
+
+        std::cout << "  speed up " << std::setprecision(1) << rebuild / incremental << "x\n";
+    }
+}
+
+
+/**
+ * @section Album hash benchmarks.
+ */
+
+/**
+ * @brief The previous Album hash, rebuilt from a multiset of the side hashes.
+ */
+static size_t rebuildHash(const Album & album)
+{
+    size_t hash{album.size()};
+
+    std::multiset<size_t> values{};
+    for (const auto & side : album)
+        values.insert(rebuildHash(side));
+
+    for (const auto & value : values)
+    {
+        hash <<= 1;
+        hash ^= std::hash<size_t>{}(value);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compare the maintained Album hash with the multiset rebuild when
+ * each candidate album is fingerprinted, as when deduplicating solutions.
+ */
+static void benchAlbumHash(void)
+{
+    std::cout << "\nAlbum pushLast/getHash/pop:\n";
+
+    const Track track{"Extra", 200};
+    for (const size_t count : {4, 12})
+    {
+        Album album{};
+        for (size_t i = 0; i < count; ++i)
+            album.push(makeSide(8));
+
+        const Side side{makeSide(7)};
+        const size_t ops{200000};
+        const std::string suffix{" (" + std::to_string(count) + " sides)"};
+
+        const double incremental{measure("maintained" + suffix, ops, [&]()
+        {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                album.push(side);
+                album.pushLast(track);
+                sink = sink + album.getHash();
+                album.pop();
+            }
+        })};
+
+        const double rebuild{measure("multiset rebuild" + suffix, ops, [&]()
+        {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                album.push(side);
+                album.pushLast(track);
+                sink = sink + rebuildHash(album);
+                album.pop();
+            }
+        })};
+
+        std::cout << "  speed up " << std::setprecision(1) << rebuild / incremental << "x\n";
+    }
+}
+
+
+/**
+ * @section Fingerprint collision benchmarks.
+ */
+
+/**
+ * @brief Count the values that collide with an earlier, different value.
+ */
+template<typename T>
+static size_t countCollisions(std::vector<T> values, size_t distinct)
+{
+    std::sort(values.begin(), values.end());
+
+    return distinct - (std::unique(values.begin(), values.end()) - values.begin());
+}
+
+/**
+ * @brief Hash and fingerprint a set of distinct albums, built by randomly
+ * dealing a track list across the sides, and count the collisions of each
+ * scheme. Only albums that differ by their sorted side durations count as
+ * distinct, as none of the schemes look at the titles.
+ * 
+ * @param name of the album set.
+ * @param albums to hash.
+ */
+static void stressAlbums(const std::string & name, const std::vector<Album> & albums)
+{
+    std::set<std::vector<std::vector<size_t>>> canonical{};
+    for (const auto & album : albums)
+    {
+        std::vector<std::vector<size_t>> sides{};
+        for (const auto & side : album)
+        {
+            auto & durations{sides.emplace_back()};
+            for (const auto & track : side)
+                durations.push_back(track.getValue());
+            std::sort(durations.begin(), durations.end());
+        }
+        std::sort(sides.begin(), sides.end());
+        canonical.insert(std::move(sides));
+    }
+
+    const size_t ops{albums.size()};
+    std::vector<size_t> rebuilt(ops);
+    std::vector<size_t> maintained(ops);
+    std::vector<Fingerprint> fingerprints(ops);
+
+    std::cout << "\n" << name << ", " << canonical.size() << " distinct albums:\n";
+    measure("multiset rebuild", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+            rebuilt[i] = rebuildHash(albums[i]);
+    });
+    measure("maintained", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+            maintained[i] = albums[i].getHash();
+    });
+    measure("fingerprint", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+            fingerprints[i] = albums[i].getFingerprint();
+    });
+
+    std::cout << "  collisions: multiset rebuild " << countCollisions(rebuilt, canonical.size())
+        << ", maintained " << countCollisions(maintained, canonical.size())
+        << ", fingerprint " << countCollisions(fingerprints, canonical.size()) << '\n';
+}
+
+/**
+ * @brief Deal the tracks randomly across the sides of an album.
+ */
+static Album dealAlbum(const std::vector<Track> & tracks, size_t sides, std::mt19937_64 & random)
+{
+    std::vector<Side> dealt(sides);
+    for (const auto & track : tracks)
+        dealt[random() % sides].push(track);
+
+    Album album{};
+    for (const auto & side : dealt)
+        album.push(side);
+
+    return album;
+}
+
+static void benchFingerprint(void)
+{
+    std::mt19937_64 random{1};
+
+    // Many arrangements of one short track list, as when deduplicating
+    // the solutions of a search.
+    std::vector<Track> tracks{};
+    for (size_t i = 0; i < 24; ++i)
+        tracks.emplace_back("Track " + std::to_string(i), 120 + random() % 8);
+
+    std::vector<Album> albums{};
+    for (size_t i = 0; i < 100000; ++i)
+        albums.push_back(dealAlbum(tracks, 4, random));
+    stressAlbums("Arrangements of 24 tracks across 4 sides", albums);
+
+    // Long sides that end with the same longest tracks, so the shift and
+    // xor rebuild only sees the shared tail of each side.
+    tracks.clear();
+    for (size_t i = 0; i < 40; ++i)
+        tracks.emplace_back("Short " + std::to_string(i), 100 + i);
+    const Track longest{"Longest", 600};
+
+    albums.clear();
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        std::vector<Side> sides(2);
+        for (const auto & track : tracks)
+            sides[random() % 2].push(track);
+
+        Album album{};
+        for (auto & side : sides)
+        {
+            for (size_t j = 0; j < 70; ++j)
+                side.push(longest);
+            album.push(side);
+        }
+        albums.push_back(album);
+    }
+    stressAlbums("Arrangements of 40 tracks across 2 sides of 70 more", albums);
+}
+
+
+/**
+ * @section time formatting benchmarks.
+ */
+
+/**
+ * @brief The previous secondsToTimeString(), using an ostringstream.
+ */
+static std::string streamTimeString(size_t seconds)
+{
+    std::ostringstream ss;
+
+    size_t hours{seconds / 3600};
+    seconds -= hours * 3600;
+
+    size_t minutes{seconds / 60};
+    seconds -= minutes * 60;
+
+    ss.width(2);
+    ss.fill('0');
+    ss << hours << ':';
+    ss.width(2);
+    ss << minutes << ':';
+    ss.width(2);
+    ss << seconds;
+
+    return ss.str();
+}
+
+static void benchTimeFormat(void)
+{
+    std::cout << "\nsecondsToTimeString:\n";
+
+    const size_t ops{1000000};
+
+    const double buffered{measure("into buffer", ops, [&]()
+    {
+        TimeBuffer buffer;
+        for (size_t i = 0; i < ops; ++i)
+            sink = sink + secondsToTimeString(i, buffer).size();
+    })};
+
+    measure("std::string", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+            sink = sink + secondsToTimeString(i).size();
+    });
+
+    const double streamed{measure("ostringstream", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+            sink = sink + streamTimeString(i).size();
+    })};
+
+    std::cout << "  speed up " << std::setprecision(1) << streamed / buffered << "x\n";
+
+    std::cout << "\nSide::format (32 tracks, reused writer):\n";
+
+    Side side{makeSide(32)};
+    side.setTitle("Side 1");
+    const size_t streams{20000};
+    Writer out{};
+
+    const double uncached{measure("uncached", streams, [&]()
+    {
+        for (size_t i = 0; i < streams; ++i)
+        {
+            out.clear();
+            side.format(out);
+            sink = sink + out.size();
+        }
+    })};
+
+    side.cacheTimes();
+    const double cached{measure("cached times", streams, [&]()
+    {
+        for (size_t i = 0; i < streams; ++i)
+        {
+            out.clear();
+            side.format(out);
+            sink = sink + out.size();
+        }
+    })};
+
+    std::cout << "  speed up " << std::setprecision(1) << uncached / cached << "x\n";
+}
+
+
+/**
+ * @section Album output benchmarks.
+ */
+
+/**
+ * @brief The previous Album::stream(), pushing each piece through iostream.
+ */
+static void streamPieces(std::ostream & os, const Album & album)
+{
+    TimeBuffer buffer;
+    const std::string c{oSep};
+    os << album.getTitle() << ":\n";
+    for (const auto & side : album)
+    {
+        os << "  " << side.getTitle() << " - " << std::to_string(side.size()) << " tracks" << "\n";
+        for (const auto & track : side)
+        {
+            os << "    ";
+            os << secondsToString(track.getValue(), buffer, false) << " - " << track.getTitle();
+            os << "\n";
+        }
+        os << "  " << secondsToString(side.getValue(), buffer, false) << "\n\n";
+    }
+    os << secondsToString(album.getValue(), buffer, false) << "\n";
+}
+
+static void benchAlbumStream(void)
+{
+    std::cout << "\nAlbum::stream (100 sides of 32 tracks):\n";
+
+    Album album{};
+    album.setTitle("Album");
+    for (size_t i = 0; i < 100; ++i)
+    {
+        Side side{makeSide(32)};
+        side.setTitle("Side " + std::to_string(i+1));
+        album.push(side);
+    }
+    const size_t streams{200};
+    Writer sample{};
+    album.format(sample);
+    const size_t bytes{streams * sample.size()};
+
+    const double pieces{measure("iostream pieces", streams, [&]()
+    {
+        std::ostringstream os{};
+        for (size_t i = 0; i < streams; ++i)
+            streamPieces(os, album);
+        sink = sink + os.tellp();
+    }, bytes)};
+
+    measure("buffered stream", streams, [&]()
+    {
+        std::ostringstream os{};
+        for (size_t i = 0; i < streams; ++i)
+            album.stream(os);
+        sink = sink + os.tellp();
+    }, bytes);
+
+    const double reused{measure("reused writer", streams, [&]()
+    {
+        Writer out{};
+        for (size_t i = 0; i < streams; ++i)
+        {
+            out.clear();
+            album.format(out);
+            sink = sink + out.size();
+        }
+    }, bytes)};
+
+    std::cout << "  speed up " << std::setprecision(1) << pieces / reused << "x\n";
+}
+
+
+/**
+ * @section Album parsing benchmarks.
+ */
+
+/**
+ * @brief The previous loadTracks() parsing, splitting each line into strings.
+ */
+static Album parseStrings(const std::string & text)
+{
+    Album album{};
+    std::istringstream is{text};
+    for (std::string line{}; std::getline(is, line); )
+    {
+        std::vector<std::string> tokens{split(line, 3)};
+        if (tokens.size() < 3)
+            continue;
+
+        std::string & label{tokens[2]};
+        label.erase(std::remove(label.begin(), label.end(), '"'), label.end());
+        if (tokens[0] == "Side")
+        {
+            const size_t pos{label.find(',')};
+            Side side{};
+            side.reserve(std::stoi(label.substr(pos+1)));
+            side.setTitle(label.substr(0, pos));
+            album.push(side);
+        }
+        else
+            album.pushLast(Track{label, timeStringToSeconds(tokens[1])});
+    }
+
+    return album;
+}
+
+/**
+ * @brief Make the CSV text of an album with uniquely titled tracks.
+ */
+static std::string makeCsv(size_t sides, size_t tracks)
+{
+    std::string text{};
+    for (size_t i = 0; i < sides; ++i)
+    {
+        text += "Side|0|\"Side " + std::to_string(i+1) + ", " + std::to_string(tracks) + " tracks\"\n";
+        for (size_t j = 0; j < tracks; ++j)
+            text += "Track|" + std::to_string(120 + (j * 37) % 300) + "|\"Track " + std::to_string(i * tracks + j) + "\"\n";
+    }
+
+    return text;
+}
+
+static void benchAlbumParse(void)
+{
+    const size_t sides{31250};
+    const size_t tracks{32};
+    std::cout << "\nAlbum::parse (" << sides * tracks << " tracks):\n";
+
+    const std::string text{makeCsv(sides, tracks)};
+
+    const double parsed{measure("single pass", sides * tracks, [&]()
+    {
+        Album album{};
+        album.parse(text);
+        sink = sink + album.getHash();
+    }, text.size())};
+
+    const double strings{measure("split into strings", sides * tracks, [&]()
+    {
+        sink = sink + parseStrings(text).getHash();
+    }, text.size())};
+
+    std::cout << "  speed up " << std::setprecision(1) << strings / parsed << "x\n";
+}
+
+
+/**
+ * @section binary Album file benchmarks.
+ */
+
+static void benchAlbumFile(void)
+{
+    const size_t sides{31250};
+    const size_t tracks{32};
+    std::cout << "\nAlbumFile (" << sides * tracks << " tracks):\n";
+
+    const std::string text{makeCsv(sides, tracks)};
+    Album album{};
+    album.setTitle("Album");
+    album.parse(text);
+    const std::string fileName{(std::filesystem::temp_directory_path() / "bench.bin").string()};
+    writeAlbumFile(album, fileName);
+
+    const double parsed{measure("parse CSV", sides * tracks, [&]()
+    {
+        Album csv{};
+        csv.parse(text);
+        sink = sink + csv.getHash();
+    }, text.size())};
+
+    const double loaded{measure("map and load", sides * tracks, [&]()
+    {
+        AlbumFile file{fileName};
+        file.map();
+        sink = sink + file.load().getHash();
+    }, text.size())};
+
+    // Reading the tables in place, without building an Album.
+    measure("map and sum durations", sides * tracks, [&]()
+    {
+        AlbumFile file{fileName};
+        file.map();
+        size_t total{};
+        for (const auto duration : file.getDurations())
+            total += duration;
+        sink = sink + total;
+    }, text.size());
+
+    std::filesystem::remove(fileName);
+
+    std::cout << "  speed up " << std::setprecision(1) << parsed / loaded << "x load over parse\n";
+}
+
+
+/**
+ * @section time parsing benchmarks.
+ */
+
+static void benchTimeParse(void)
+{
+    std::cout << "\ntimeStringToSeconds:\n";
+
+    for (const size_t count : {1000, 100000})
+    {
+        std::vector<std::string> times{};
+        std::vector<std::string_view> views{};
+        times.reserve(count);
+        size_t bytes{};
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t seconds{(i * 7919) % 40000};
+            times.push_back(i % 3 ? secondsToTimeString(seconds) : std::to_string(seconds));
+            bytes += times.back().size();
+        }
+        for (const auto & time : times)
+            views.push_back(time);
+
+        const std::string suffix{" (" + std::to_string(count) + " times)"};
+        measure("single" + suffix, count, [&]()
+        {
+            for (const auto & time : times)
+                sink = sink + timeStringToSeconds(time);
+        }, bytes);
+
+        std::vector<size_t> seconds(count);
+        measure("batch" + suffix, count, [&]()
+        {
+            sink = sink + timeStringsToSeconds(views, seconds);
+        }, bytes);
+    }
+}
+
+
+/**
+ * @section line splitting benchmarks.
+ */
+
+static std::vector<std::string_view> splitLines(std::string_view text)
+{
+    std::vector<std::string_view> lines{};
+    for (size_t start{}, end{}; (end = text.find('\n', start)) != std::string_view::npos; start = end + 1)
+        lines.push_back(text.substr(start, end - start));
+
+    return lines;
+}
+
+static void benchSplit(void)
+{
+    std::cout << "\nsplit:\n";
+
+    for (const size_t sides : {32, 3125})
+    {
+        const std::string text{makeCsv(sides, 32)};
+        const auto lines{splitLines(text)};
+        const size_t count{lines.size()};
+        const std::string suffix{" (" + std::to_string(count) + " lines)"};
+
+        const double strings{measure("into strings" + suffix, count, [&]()
+        {
+            for (const auto line : lines)
+                sink = sink + split(line, 3).size();
+        }, text.size())};
+
+        const double views{measure("into views" + suffix, count, [&]()
+        {
+            std::array<std::string_view, 3> items{};
+            for (const auto line : lines)
+                sink = sink + split(line, items);
+        }, text.size())};
+
+        std::cout << "  speed up " << std::setprecision(1) << strings / views << "x\n";
+    }
+}
+
+
+/**
+ * @section TextFile benchmarks.
+ */
+
+static void benchTextFile(void)
+{
+    std::cout << "\nTextFile:\n";
+
+    const std::string fileName{(std::filesystem::temp_directory_path() / "bench.txt").string()};
+    for (const size_t sides : {32, 31250})
+    {
+        const std::string text{makeCsv(sides, 32)};
+        if (std::ofstream os{fileName, std::ios::binary})
+            os << text;
+
+        TextFile<> file{fileName};
+        file.read();
+        const size_t count{file.size()};
+        const std::string suffix{" (" + std::to_string(count) + " lines)"};
+
+        measure("read" + suffix, count, [&]()
+        {
+            TextFile<> read{fileName};
+            read.read();
+            sink = sink + read.size();
+        }, text.size());
+
+        TextFile<> mapped{fileName};
+        measure("map" + suffix, count, [&]()
+        {
+            mapped.map();
+            sink = sink + mapped.size();
+        }, text.size());
+
+        measure("equal" + suffix, count, [&]()
+        {
+            sink = sink + file.equal(mapped);
+        }, text.size());
+
+        measure("cursor" + suffix, count, [&]()
+        {
+            auto cursor{file.cursor()};
+            size_t lines{};
+            for (std::string_view line{}; cursor.next(line); )
+                ++lines;
+            sink = sink + lines;
+        }, text.size());
+
+        // The terminator scan that indexes the lines, against memchr.
+        const char * const last{text.data() + text.size()};
+        measure("memchr newlines" + suffix, count, [&]()
+        {
+            size_t lines{};
+            for (const char * p{text.data()}; (p = static_cast<const char *>(std::memchr(p, '\n', last - p))); ++p)
+                ++lines;
+            sink = sink + lines;
+        }, text.size());
+
+        measure("findTerminator" + suffix, count, [&]()
+        {
+            size_t lines{};
+            for (const char * p{text.data()}; (p = findTerminator(p, last)) != last; ++p)
+                ++lines;
+            sink = sink + lines;
+        }, text.size());
+    }
+
+    std::filesystem::remove(fileName);
+}
+
+
+/**
+ * @section Side and Album push/pop benchmarks.
+ */
+
+static void benchPushPop(void)
+{
+    std::cout << "\nSide and Album push/pop:\n";
+
+    const Track track{"Extra", 200};
+    for (const size_t count : {16, 1024})
+    {
+        const size_t rounds{1000000 / count};
+        const std::string suffix{" (" + std::to_string(count) + " deep)"};
+
+        Side side{};
+        side.reserve(count);
+        measure("Side push/pop" + suffix, rounds * count * 2, [&]()
+        {
+            for (size_t round = 0; round < rounds; ++round)
+            {
+                for (size_t i = 0; i < count; ++i)
+                    side.push(track);
+                sink = sink + side.getHash();
+                for (size_t i = 0; i < count; ++i)
+                    side.pop();
+            }
+        });
+
+        const Side other{makeSide(8)};
+        const size_t sides{std::min(count, size_t{64})};
+        Album album{};
+        measure("Album push/pop" + suffix, rounds * sides * 2, [&]()
+        {
+            for (size_t round = 0; round < rounds; ++round)
+            {
+                for (size_t i = 0; i < sides; ++i)
+                    album.push(other);
+                sink = sink + album.getHash();
+                for (size_t i = 0; i < sides; ++i)
+                    album.pop();
+            }
+        });
+    }
+}
+
+
+/**
+ * @brief Build a candidate album of 8 sides of 16 tracks, as a search does
+ * for each candidate, then tear it down. The side titles are too long for
+ * the small string buffer, so they use the album's resource too.
+ */
+static void buildCandidate(const std::vector<Track> & tracks, const Album::allocator_type & allocator)
+{
+    Album album{allocator};
+    album.reserve(8);
+    for (size_t i = 0; i < 8; ++i)
+    {
+        album.emplace("A candidate side with a long title");
+        for (size_t j = 0; j < 16; ++j)
+            album.pushLast(tracks[i * 16 + j]);
+    }
+    sink = sink + album.getHash();
+}
+
+/**
+ * @brief Compare building and tearing down candidate albums on the heap, on
+ * a pool and in an arena that is released after each candidate.
+ */
+static void benchCandidates(void)
+{
+    std::cout << "\nBuild and tear down candidate albums:\n";
+
+    std::vector<Track> tracks{};
+    for (size_t i = 0; i < 128; ++i)
+        tracks.emplace_back("Track " + std::to_string(i), 120 + (i * 37) % 300);
+
+    const size_t ops{100000};
+    const double heap{measure("default heap", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+            buildCandidate(tracks, {});
+    })};
+
+    std::pmr::unsynchronized_pool_resource pool{};
+    const double pooled{measure("unsynchronized pool", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+            buildCandidate(tracks, &pool);
+    })};
+
+    std::vector<std::byte> buffer(64 * 1024);
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};
+    const double released{measure("monotonic arena", ops, [&]()
+    {
+        for (size_t i = 0; i < ops; ++i)
+        {
+            buildCandidate(tracks, &arena);
+            arena.release();
+        }
+    })};
+
+    std::cout << "  speed up " << std::setprecision(1) << heap / pooled << "x pool, " << heap / released << "x arena\n";
+}
+
+/**
+ * @section loadTracks benchmarks.
+ */
+
+static void benchLoadTracks(void)
+{
+    std::cout << "\nloadTracks:\n";
+
+    const std::string fileName{(std::filesystem::temp_directory_path() / "bench.txt").string()};
+    for (const size_t sides : {32, 31250})
+    {
+        const std::string text{makeCsv(sides, 32)};
+        if (std::ofstream os{fileName, std::ios::binary})
+            os << text;
+
+        // readAlbum() is shared with loadTracks() in test.cpp.
+        const size_t count{sides * 32};
+        const std::string suffix{" (" + std::to_string(count) + " tracks)"};
+        measure("read and parse" + suffix, count, [&]()
+        {
+            sink = sink + readAlbum(fileName).getHash();
+        }, text.size());
+
+        std::pmr::monotonic_buffer_resource arena{};
+        measure("read and parse, arena" + suffix, count, [&]()
+        {
+            sink = sink + readAlbum(fileName, &arena).getHash();
+            arena.release();
+        }, text.size());
+    }
+
+    std::filesystem::remove(fileName);
+}
+
+
+/**
+ * Benchmark entry point.
+ *
+ * @param argc command line argument count.
+ * @param argv command line arguments, an optional benchmark name filter.
+ * @return error value or 0 if no errors.
+ */
+
+int main(int argc, char * argv[])
+{
+    const std::string filter{argc > 1 ? argv[1] : ""};
+
+    struct Benchmark
+    {
+        const char * name;
+        void (*func)(void);
+    };
+
+    const Benchmark benchmarks[]
+    {
+        { "timeparse", benchTimeParse },
+        { "timeformat", benchTimeFormat },
+        { "split", benchSplit },
+        { "textfile", benchTextFile },
+        { "pushpop", benchPushPop },
+        { "candidates", benchCandidates },
+        { "sidehash", benchSideHash },
+        { "albumhash", benchAlbumHash },
+        { "fingerprint", benchFingerprint },
+        { "stream", benchAlbumStream },
+        { "parse", benchAlbumParse },
+        { "loadtracks", benchLoadTracks },
+        { "albumfile", benchAlbumFile },
+    };
+
+    std::cout << "\nRunning benchmarks.\n";
+
+    for (const auto & benchmark : benchmarks)
+        if (std::string_view{benchmark.name}.find(filter) != std::string_view::npos)
+            benchmark.func();
+
+    return 0;
+}
@@ -0,0 +1,349 @@
+/**
+ * @file    sweep.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Scaling sweep of the Balancer modes over synthetic track lists.
+ *
+ * Build and run using:
+ *    make sweep
+ *
+ * Usage:
+ *    ./sweep [-g count] [-r seed] [-t distribution] [-m min] [-M max]
+ *            [-b sides] [-l limit] [-w wait] [-n largest] [-p program]
+ *            [-o file]
+ *
+ *    -g count        write a generated track list to stdout and exit.
+ *    -r seed         random number seed (default 1).
+ *    -t distribution uniform, normal or exponential (default uniform).
+ *    -m min, -M max  shortest and longest track in seconds (default 60, 600).
+ *    -b sides        sides to balance across (default 4).
+ *    -l limit        stop growing a mode once a run takes this many
+ *                    seconds (default 1).
+ *    -w wait         abandon a run after this many seconds (default 10).
+ *    -n largest      largest track count to try (default 100000).
+ *    -p program      time the Balancer program rather than the in-process
+ *                    engine.
+ *    -o file         also write the results as CSV to the file.
+ *
+ */
+
+#include <iostream>
+#include <cerrno>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "Generator.h"
+#include "Engine.h"
+#include "Process.h"
+
+
+/**
+ * @section sweep configuration.
+ */
+
+struct Mode
+{
+    const char * name;      // Balancer option(s) for the mode.
+    Config config;          // Equivalent engine configuration.
+};
+
+struct Options
+{
+    Spec spec{};
+    size_t sides{4};
+    double limit{1.0};
+    double wait{10.0};
+    size_t largest{100000};
+    std::string program{};
+    std::string output{};
+};
+
+struct Run
+{
+    std::string mode;
+    size_t tracks;
+    size_t sides;
+    double seconds;         // Run time, or the wait if abandoned.
+    size_t longest;         // Longest side, 0 if not known.
+    bool finished;
+    bool failed;            // The program could not be run or failed.
+};
+
+struct Timing
+{
+    double seconds;
+    size_t longest;
+};
+
+
+/**
+ * @section Support code.
+ */
+
+static size_t longestSide(const Album & album)
+{
+    size_t longest{};
+    for (const auto & side : album)
+        longest = std::max(longest, side.getValue());
+
+    return longest;
+}
+
+/**
+ * @brief Balance the tracks in a child process, so that a run that takes
+ * too long, as brute force soon does, can be abandoned.
+ *
+ * @param config the balancing configuration.
+ * @param tracks to be balanced.
+ * @param wait maximum time to wait for the child in seconds.
+ * @param timing set to the time taken and the longest side.
+ * @return true if the child finished in time, false otherwise.
+ */
+static bool balanceChild(const Config & config, const std::vector<Track> & tracks, double wait, Timing & timing)
+{
+    int fds[2];
+    if (pipe(fds) == -1)
+        return false;
+
+    std::cout.flush();
+    const pid_t pid{fork()};
+    if (pid == 0)
+    {
+        close(fds[0]);
+        const auto start{std::chrono::steady_clock::now()};
+        const size_t longest{longestSide(balance(tracks, config))};
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        const Timing result{elapsed.count(), longest};
+        const bool written{write(fds[1], &result, sizeof(result)) == sizeof(result)};
+        _exit(written ? 0 : 1);
+    }
+    close(fds[1]);
+
+    bool finished{};
+    if (pid != -1)
+    {
+        // Retry an interrupted poll with the time remaining.
+        const auto deadline{std::chrono::steady_clock::now() + std::chrono::duration<double>{wait}};
+        int polled{};
+        do
+        {
+            const auto left{std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now())};
+            pollfd ready{fds[0], POLLIN, 0};
+            polled = poll(&ready, 1, static_cast<int>(std::max(left.count(), std::chrono::milliseconds::rep{0})));
+        } while ((polled == -1) && (errno == EINTR));
+
+        if (polled == 1)
+            finished = read(fds[0], &timing, sizeof(timing)) == sizeof(timing);
+        if (!finished)
+            kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+    close(fds[0]);
+
+    return finished;
+}
+
+/**
+ * @brief Time a single run of a mode, either in-process or by running the
+ * Balancer program on the generated tracks.
+ */
+static Run runMode(const Options & options, const Mode & mode, const std::vector<Track> & tracks)
+{
+    Config config{mode.config};
+    size_t total{};
+    for (const auto & track : tracks)
+        total += track.getValue();
+
+    if (config.duration)
+        config.duration = (total + options.sides - 1) / options.sides;
+    else
+        config.boxes = options.sides;
+
+    Run run{mode.name, tracks.size(), sideCount(tracks, config), options.wait, 0, false, false};
+    if (options.program.empty())
+    {
+        Timing timing{};
+        run.finished = balanceChild(config, tracks, options.wait, timing);
+        if (run.finished)
+        {
+            run.seconds = timing.seconds;
+            run.longest = timing.longest;
+        }
+
+        return run;
+    }
+
+    // A unique file created by mkstemp(), so concurrent sweeps don't share it.
+    std::string fileName{(std::filesystem::temp_directory_path() / "sweepXXXXXX").string()};
+    const int fd{mkstemp(fileName.data())};
+    Writer out{};
+    formatInput(out, tracks);
+    const bool written{(fd != -1) && out.write(fd)};
+    if (fd != -1)
+        close(fd);
+
+    std::string args{options.program + " " + mode.name + " "};
+    if (config.duration)
+        args += std::to_string(config.duration);
+    else
+        args += std::to_string(config.boxes);
+
+    if (written)
+    {
+        // The program is killed if it takes longer than the wait.
+        // The file name is added unsplit, so it may contain spaces.
+        auto argv{splitArguments(args + " -i")};
+        argv.push_back(fileName);
+        const Result result{spawn(argv, options.wait)};
+        run.finished = !result.timedOut;
+        run.failed = run.finished && !(WIFEXITED(result.status) && (WEXITSTATUS(result.status) == 0));
+        if (run.finished)
+            run.seconds = result.usage.wall;
+    }
+    else
+        run.failed = true;
+
+    if (fd != -1)
+        unlink(fileName.c_str());
+
+    return run;
+}
+
+static void display(std::ostream & os, const Run & run, bool csv)
+{
+    if (csv)
+    {
+        os << run.mode << ',' << run.tracks << ',' << run.sides << ',' << run.seconds << ',' << run.longest;
+        os << ',' << (run.failed ? "failed" : run.finished ? "yes" : "no") << '\n';
+    }
+    else
+    {
+        os << "  " << std::left << std::setw(8) << run.mode << std::right << std::setw(10) << run.tracks
+           << std::setw(8) << run.sides << std::setw(14) << std::fixed << std::setprecision(6) << run.seconds;
+        if (run.failed)
+            os << "     failed" << std::endl;
+        else if (run.finished)
+            os << std::setw(10) << run.longest << std::endl;
+        else
+            os << "  abandoned" << std::endl;
+    }
+}
+
+static bool parseOptions(int argc, char *argv[], Options & options, size_t & generate)
+{
+    int option;
+    while ((option = getopt(argc, argv, "g:r:t:m:M:b:l:w:n:p:o:")) != -1)
+    {
+        switch (option)
+        {
+        case 'g': if (!parseValue(optarg, generate)) return false; break;
+        case 'r': if (!parseValue(optarg, options.spec.seed)) return false; break;
+        case 't': if (!parseDistribution(optarg, options.spec.distribution)) return false; break;
+        case 'm': if (!parseValue(optarg, options.spec.minimum)) return false; break;
+        case 'M': if (!parseValue(optarg, options.spec.maximum)) return false; break;
+        case 'b': if (!parseValue(optarg, options.sides)) return false; options.sides = std::max(options.sides, size_t{1}); break;
+        case 'l': if (!parseValue(optarg, options.limit)) return false; break;
+        case 'w': if (!parseValue(optarg, options.wait)) return false; break;
+        case 'n': if (!parseValue(optarg, options.largest)) return false; break;
+        case 'p': options.program = optarg; break;
+        case 'o': options.output = optarg; break;
+        default: return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * Sweep entry point.
+ *
+ * @param  argc - command line argument count.
+ * @param  argv - command line argument vector.
+ * @return error value or 0 if no errors.
+ */
+
+int main(int argc, char *argv[])
+{
+    Options options{};
+    size_t generate{};
+    if (!parseOptions(argc, argv, options, generate))
+    {
+        std::cerr << "Usage: " << argv[0] << " [-g count] [-r seed] [-t distribution] [-m min] [-M max]"
+            " [-b sides] [-l limit] [-w wait] [-n largest] [-p program] [-o file]\n";
+        return 1;
+    }
+
+    if (generate)
+    {
+        options.spec.count = generate;
+        Writer out{};
+        formatInput(out, generateTracks(options.spec));
+
+        return out.write(STDOUT_FILENO) ? 0 : 1;
+    }
+
+    const Mode modes[]
+    {
+        { "-b", Config{} },
+        { "-d", Config{.duration = 1} },
+        { "-x -b", Config{.ideal = true} },
+        { "-s -b", Config{.shuffle = true} },
+        { "-f -b", Config{.force = true} },
+    };
+
+    std::cout << "\nScaling sweep across " << options.sides << " sides, stopping each mode after "
+        << options.limit << "s.\n\n";
+    std::cout << "  " << std::left << std::setw(8) << "mode" << std::right << std::setw(10) << "tracks"
+        << std::setw(8) << "sides" << std::setw(14) << "seconds" << std::setw(10) << "longest" << '\n';
+
+    std::vector<Run> runs{};
+    for (const auto & mode : modes)
+    {
+        // Grow the track count by half each time, until a run takes too long.
+        for (size_t count = 8; count <= options.largest; count += count / 2)
+        {
+            options.spec.count = count;
+            runs.push_back(runMode(options, mode, generateTracks(options.spec)));
+            display(std::cout, runs.back(), false);
+            if ((!runs.back().finished) || (runs.back().failed) || (runs.back().seconds > options.limit))
+                break;
+        }
+        std::cout << '\n';
+    }
+
+    if (!options.output.empty())
+    {
+        std::ofstream os{options.output};
+        os << "mode,tracks,sides,seconds,longest,finished\n";
+        for (const auto & run : runs)
+            display(os, run, true);
+    }
+
+    return 0;
+}
@@ -34,9 +34,28 @@
 #include <iostream>
 #include <algorithm>
 #include <filesystem>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <sstream>
+#include <iomanip>
+#include <charconv>
+#include <cstring>
+#include <array>
+#include <map>
+#include <csignal>
+#include <cstdlib>
+#include <new>
+#include <sys/wait.h>
 
 #include "TextFile.h"
 #include "Side.h"
+#include "Engine.h"
+#include "Process.h"
+#include "AlbumFile.h"
+#include "Generator.h"
+#include "Oracle.h"
+#include "Validator.h"
 
 #include "unittest.h"
 
@@ -49,9 +68,97 @@ const std::string rootDir{"testdata"};
 const std::string inputDir{rootDir + "/input/"};
 const std::string outputDir{rootDir + "/output/"};
 const std::string expectedDir{rootDir + "/expected/"};
+const std::string baselineFile{rootDir + "/baseline.csv"};
 
 
-static std::vector<std::string> commands{};
+/**
+ * @brief Count the heap allocations made by each thread, so that a test can
+ * check code that should only use a given memory resource.
+ */
+static thread_local size_t heapAllocations{};
+
+[[gnu::noinline]] void * operator new(size_t size)
+{
+    ++heapAllocations;
+    if (void * memory{std::malloc(size ? size : 1)})
+        return memory;
+
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void * memory) noexcept { std::free(memory); }
+[[gnu::noinline]] void operator delete(void * memory, size_t) noexcept { std::free(memory); }
+
+/**
+ * @brief Count the aligned allocations too, as made by the default memory
+ * resource of a polymorphic allocator.
+ */
+[[gnu::noinline]] void * operator new(size_t size, std::align_val_t align)
+{
+    ++heapAllocations;
+    const size_t alignment{static_cast<size_t>(align)};
+    if (void * memory{std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)})
+        return memory;
+
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void * memory, std::align_val_t) noexcept { std::free(memory); }
+[[gnu::noinline]] void operator delete(void * memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+
+
+/**
+ * @brief Performance gate settings, from the command line.
+ */
+struct Gate
+{
+    size_t runs{5};         // -c: runs of each command to take the median of.
+    double tolerance{25.0}; // -t: percentage slower than the baseline allowed.
+    bool record{};          // -r: record a new baseline.
+    bool strict{};          // -s: fail, rather than warn, when slower.
+};
+
+static Gate gate{};
+
+
+/**
+ * @brief A Balancer command that was executed and the resources it used.
+ */
+struct Command
+{
+    std::string line;
+    std::vector<std::string> args;
+    Usage usage;
+};
+
+static std::vector<Command> commands{};
+static std::map<std::string, std::string> outputs{};
+
+
+/**
+ * @brief A Balancer command queued to run on the worker pool ahead of the
+ * test that checks its result.
+ */
+struct Job
+{
+    std::string command;
+    std::vector<std::string> args;
+    std::promise<Result> promise;
+    std::future<Result> result;
+};
+
+/**
+ * @brief The queued jobs and the workers that run them. Each worker takes
+ * the next job that has not been started.
+ */
+struct JobQueue
+{
+    std::vector<Job> jobs{};
+    std::atomic<size_t> next{};     // Index of the next job to start.
+    std::vector<std::jthread> workers{};
+};
+
+static JobQueue jobQueue{};
 
 
 static bool createDirectory(const std::string & path)
@@ -59,18 +166,142 @@ static bool createDirectory(const std::string & path)
     return std::filesystem::create_directories(path);
 }
 
-static int execute(const std::string & command)
+/**
+ * @brief Execute a command without a shell, collecting the result if the
+ * command has already been queued.
+ * 
+ * @param command as listed by displayCommands().
+ * @param args the program name followed by its arguments.
+ * @return Result the wait status and the captured output.
+ */
+static Result execute(const std::string & command, const std::vector<std::string> & args)
 {
-    commands.push_back(command);
     // std::cout << "Executing: '" << command << "'\n";
 
-    return system(command.c_str());
+    auto isCommand{[&command](const Job & job) { return job.command == command; }};
+    auto & jobs{jobQueue.jobs};
+    auto it{std::find_if(jobs.begin(), jobs.end(), isCommand)};
+    Result result{((it != jobs.end()) && (it->result.valid())) ? it->result.get() : spawn(args)};
+    commands.push_back(Command{command, args, result.usage});
+
+    return result;
+}
+
+/**
+ * @brief Queue a command to be run by the worker pool. All commands must be
+ * queued before startWorkers() is called.
+ * 
+ * @param command as listed by displayCommands().
+ * @param args the program name followed by its arguments.
+ */
+static void queue(const std::string & command, const std::vector<std::string> & args)
+{
+    Job job{command, args, {}, {}};
+    job.result = job.promise.get_future();
+    jobQueue.jobs.push_back(std::move(job));
+}
+
+/**
+ * @brief Start a worker per core to run the queued commands concurrently.
+ * The results are collected in test order by execute().
+ * 
+ * @return size_t the number of workers started.
+ */
+static size_t startWorkers(void)
+{
+    auto & jobs{jobQueue.jobs};
+    const size_t cores{std::max(std::thread::hardware_concurrency(), 1U)};
+    const size_t count{std::min(cores, jobs.size() - std::min(jobs.size(), size_t{jobQueue.next}))};
+    for (size_t i = 0; i < count; ++i)
+        jobQueue.workers.emplace_back([&jobs]()
+        {
+            for (size_t index{jobQueue.next++}; index < jobs.size(); index = jobQueue.next++)
+                jobs[index].promise.set_value(spawn(jobs[index].args));
+        });
+
+    return count;
+}
+
+static void stopWorkers(void)
+{
+    jobQueue.workers.clear();
 }
 
 static int displayCommands(void)
 {
-    for (auto & command : commands)
-        std::cout << "  " << command << '\n';
+    std::cout << std::fixed;
+    for (const auto & command : commands)
+    {
+        const auto & usage{command.usage};
+        std::cout << "  " << command.line << "  [wall " << std::setprecision(3) << usage.wall
+            << "s user " << usage.user << "s sys " << usage.system << "s rss " << usage.maxRss
+            << "KB faults " << usage.minorFaults << '/' << usage.majorFaults << "]\n";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+
+    return commands.size();
+}
+
+/**
+ * @brief Quote a command for a CSV file, doubling any quotes.
+ */
+static std::string quoteCsv(const std::string & text)
+{
+    std::string quoted{"\""};
+    for (const char c : text)
+    {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+
+    return quoted + '"';
+}
+
+/**
+ * @brief Escape a string for use in JSON.
+ */
+static std::string escapeJson(const std::string & text)
+{
+    std::string escaped{};
+    for (const char c : text)
+    {
+        if ((c == '"') || (c == '\\'))
+            escaped += '\\';
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+/**
+ * @brief Write the resources used by each executed command as CSV and JSON
+ * reports, for dashboards.
+ * 
+ * @param fileName of the reports, without the extension.
+ * @return int the number of commands reported.
+ */
+static int writeUsageReport(const std::string & fileName)
+{
+    std::ofstream csv{fileName + ".csv"};
+    csv << "command,wall,user,system,maxrss,minflt,majflt\n";
+
+    std::ofstream json{fileName + ".json"};
+    json << "[\n";
+
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        const auto & command{commands[i].line};
+        const auto & usage{commands[i].usage};
+        csv << quoteCsv(command) << ',' << usage.wall << ',' << usage.user << ',' << usage.system << ','
+            << usage.maxRss << ',' << usage.minorFaults << ',' << usage.majorFaults << '\n';
+
+        json << "  { \"command\": \"" << escapeJson(command) << "\", \"wall\": " << usage.wall
+            << ", \"user\": " << usage.user << ", \"system\": " << usage.system
+            << ", \"maxrss\": " << usage.maxRss << ", \"minflt\": " << usage.minorFaults
+            << ", \"majflt\": " << usage.majorFaults << " }" << (i+1 < commands.size() ? ",\n" : "\n");
+    }
+    json << "]\n";
 
     return commands.size();
 }
@@ -90,8 +321,8 @@ static int genTestScript(const std::string & fileName, const char * program)
         os << "# This file was generated as \"" << fileName << "\" using " << program << '\n';
         os << "#\n";
         os << '\n';
-        for (auto command : commands)
-            os << command << '\n';
+        for (const auto & command : commands)
+            os << command.line << '\n';
 
         os.close();
 
@@ -114,34 +345,140 @@ static int genTestScript(const std::string & fileName, const char * program)
  */
 
 /**
- * @brief Constructs a Balancer command using supplied parameters and executes it.
+ * @brief Constructs the Balancer command line, as listed by displayCommands().
+ * The output is captured in memory, the redirect shows where the expected
+ * output would be written when the command is run by hand.
+ */
+static std::string buildCommand(const std::string & options, const std::string & inputFileName, const std::string & outputFileName)
+{
+    return "Balancer " + options + " -i " + inputDir + inputFileName + " > " + outputDir + outputFileName;
+}
+
+/**
+ * @brief Constructs the Balancer arguments, the shell is not used.
+ */
+static std::vector<std::string> buildArguments(const std::string & options, const std::string & inputFileName)
+{
+    return splitArguments("Balancer " + options + " -i " + inputDir + inputFileName);
+}
+
+/**
+ * @brief A Balancer command run by a test, identified by its output file.
+ */
+struct Invocation
+{
+    const char * options;
+    const char * inputFileName;
+    const char * outputFileName;
+    bool slow;                      // Brute force, only run for all tests.
+};
+
+/**
+ * @brief Every Balancer command used by the tests. The tests and
+ * queueCommands() both build their commands from this table, so a queued
+ * command always matches the test that collects it.
+ */
+static const Invocation invocations[]
+{
+    { "-b 1 -p", "TestTimeFormats.txt", "testtime1.txt", false },
+    { "-b 1", "TestTimeFormats.txt", "testtime2.txt", false },
+    { "-b 1 -s", "TestTimeFormats.txt", "testtime3.txt", false },
+    { "-b 1 -c -a '|'", "TestTimeFormats.txt", "testtime4.txt", false },
+
+    { "-b 4 -c -a '|' -p", "BeaucoupFish.txt", "split.txt", false },
+    { "-b 4 -c -a '|' -p -s", "BeaucoupFish.txt", "shuffle.txt", false },
+    { "-b 4 -c -a '|' -p -f", "BeaucoupFish.txt", "force.txt", true },
+    { "-d 22:00 -e -c -a '|' -p", "QueenBest.txt", "split21.txt", false },
+    { "-b 12 -c -a '|' -p", "QueenBest.txt", "split22.txt", false },
+    { "-d 22:00 -e -c -a '|' -p -s", "QueenBest.txt", "shuffle23.txt", false },
+
+    { "-b 4 -x", "Ideal.txt", "ideal11.txt", false },
+    { "-d 20:00 -x", "Ideal.txt", "ideal12.txt", false },
+    { "-b 4 -x -s", "Ideal.txt", "ideal21.txt", false },
+    { "-d 20:00 -x -s", "Ideal.txt", "ideal22.txt", false },
+    { "-b 4 -x -f", "Ideal.txt", "ideal31.txt", true },
+    { "-d 20:00 -x -f", "Ideal.txt", "ideal32.txt", true },
+};
+
+/**
+ * @brief Executes the Balancer command for an output file, keeping the
+ * output for compareAlbums().
  * 
- * @param options to be tested.
- * @param inputFileName without the input directory.
  * @param outputFileName without the output directory.
- * @return int the command return value.
+ * @return int the command return value, or -1 if there is no such command.
  */
-static int executeCommand(const std::string & options, const std::string & inputFileName, const std::string & outputFileName)
+static int executeCommand(const std::string & outputFileName)
 {
-    std::string command{"Balancer " + options + " -i " + inputDir + inputFileName + " > " + outputDir + outputFileName};
+    auto isOutput{[&outputFileName](const Invocation & item) { return item.outputFileName == outputFileName; }};
+    const auto it{std::find_if(std::begin(invocations), std::end(invocations), isOutput)};
+    if (it == std::end(invocations))
+    {
+        std::cout << "No Balancer command writes " << outputFileName << '\n';
+        return -1;
+    }
+
+    const std::string command{buildCommand(it->options, it->inputFileName, outputFileName)};
+    Result result{execute(command, buildArguments(it->options, it->inputFileName))};
+    outputs[outputFileName] = std::move(result.output);
+
+    return result.status;
+}
 
-    return execute(command);
+/**
+ * @brief Queue every Balancer command used by the tests so that they run
+ * concurrently. Each test's output file is unique, so the commands are
+ * independent.
+ * 
+ * @param testAll true if the slow brute force tests are to be run.
+ */
+static void queueCommands(const bool testAll)
+{
+    for (const auto & item : invocations)
+        if (testAll || !item.slow)
+            queue(buildCommand(item.options, item.inputFileName, item.outputFileName),
+                buildArguments(item.options, item.inputFileName));
 }
 
 /**
- * @brief compares 2 files (the expected file with the generated file).
+ * @brief compares the expected file with the output captured by
+ * executeCommand(), reporting the first difference.
  * 
  * @param fileName without the directory.
- * @return true if the 2 files are the same, false otherwise.
+ * @return true if the output matches the file, false otherwise.
  */
 static bool compareAlbums(const std::string & fileName)
 {
-    TextFile<> expected{expectedDir + fileName};
-    expected.read();
-    TextFile<> output{outputDir + fileName};
-    output.read();
+    TextFile<>::Cursor expected{TextFile<>{expectedDir + fileName}.cursor()};
+    TextFile<>::Cursor output{outputs[fileName]};
+
+    const auto difference{expected.compare(output)};
+    if (difference.found)
+    {
+        std::cout << fileName << " differs at line " << difference.expectedLine
+            << " (output line " << difference.actualLine << ")\n";
+        std::cout << "  expected: '" << difference.expected << "'\n";
+        std::cout << "  actual:   '" << difference.actual << "'\n";
+    }
+
+    return !difference.found;
+}
+
+
+/**
+ * @brief Reads a file both ways and compares the memory mapped lines with
+ * those read from the stream.
+ * 
+ * @param fileName including the directory.
+ * @return true if the lines are the same, false otherwise.
+ */
+static bool compareMapped(const std::string & fileName)
+{
+    TextFile<> stream{fileName};
+    TextFile<> mapped{fileName};
+    if (stream.read() || mapped.map())
+        return false;
 
-    return expected.equal(output);
+    return stream.equal(mapped) && mapped.equal(TextFile<>{mapped});
 }
 
 
@@ -149,63 +486,169 @@ static bool compareAlbums(const std::string & fileName)
  * @brief Loads in a CSV ('|') output file and converts it to a Album.
  * 
  * @param inputFile to load, must use '|' as a delimiter.
+ * @param directory containing inputFile, the input directory by default.
  * @return Album representation of inputFile.
  */
-Album loadTracks(const std::string & inputFile)
+Album loadTracks(const std::string & inputFile, const std::string & directory = inputDir)
 {
-	Album album{};
+	Album album{readAlbum(directory + inputFile)};
 	album.setTitle(inputFile);
 
+    return album;
+}
+
+
+
+/**
+ * @brief Loads in a Balancer input file of whitespace separated time and
+ * title pairs.
+ * 
+ * @param inputFile to load, without the input directory.
+ * @return std::vector<Track> the tracks in file order.
+ */
+static std::vector<Track> loadInput(const std::string & inputFile)
+{
+    std::vector<Track> tracks{};
+
     TextFile input{inputDir + inputFile};
-	if (!input.exists())
-	    return album;
-
-    input.read();
-
-	// Parse file.
-	for (const auto & line : input)
-	{
-		// Split line into 3 tokens.
-		std::vector<std::string> tokens{split(line, 3)};
-
-		// Remove quotes from label.
-		std::string label{tokens[2]};
-		label.erase(std::find(label.begin(), label.end(), '"'));
-		label.erase(std::find(label.begin(), label.end(), '"'));
-
-		// Parse line type.
-		if (tokens[0].compare("Side") == 0)
-		{
-			// Find track count.
-		    size_t pos{label.find_first_of(",")};
-			if (pos == std::string::npos)
-				break;
-
-			size_t digits{};
-			auto tracks{std::stoi(label.substr(pos+1), &digits)};
-
-			// Push the side to the album.
-			Side side{};
-			side.reserve(tracks);
-			side.setTitle(label.substr(0, pos));
-			album.push(side);
-		}
-		else
-		{
-			// Extract seconds.
-		    size_t seconds{timeStringToSeconds(tokens[1])};
-
-			// Push the track to the last side of the album.
-		    Track track{label, seconds};
-			album.pushLast(track);
-		}
-	}
-
-	album.getHash();
+    auto cursor{input.cursor()};
 
-    return album;
+    for (std::string_view line{}; cursor.next(line); )
+    {
+        const size_t pos{line.find_first_of(whitespace)};
+        if (pos == std::string::npos)
+            continue;
+
+        const size_t start{line.find_first_not_of(whitespace, pos)};
+        const std::string_view title{start == std::string::npos ? std::string_view{} : line.substr(start)};
+        tracks.emplace_back(title, timeStringToSeconds(line.substr(0, pos)));
+    }
+
+    return tracks;
+}
+
+
+
+/**
+ * @section performance regression gate.
+ *
+ */
+
+/**
+ * @brief Load the baseline median wall time of each command.
+ * 
+ * @param fileName of the baseline.
+ * @return std::map<std::string, double> the median of each command.
+ */
+static std::map<std::string, double> loadBaseline(const std::string & fileName)
+{
+    std::map<std::string, double> baseline{};
+    if (!std::filesystem::exists(fileName))
+        return baseline;
+
+    auto cursor{TextFile<>{fileName}.cursor()};
+    for (std::string_view line{}; cursor.next(line); )
+    {
+        const size_t comma{line.rfind(',')};
+        if ((comma == std::string_view::npos) || (comma < 2) || (line.front() != '"'))
+            continue;
+
+        std::string command{};
+        const std::string_view quoted{line.substr(1, comma - 2)};
+        for (size_t i = 0; i < quoted.size(); ++i)
+        {
+            command += quoted[i];
+            if ((quoted[i] == '"') && (i+1 < quoted.size()) && (quoted[i+1] == '"'))
+                ++i;
+        }
+
+        double median{};
+        const std::string_view value{line.substr(comma + 1)};
+        std::from_chars(value.data(), value.data() + value.size(), median);
+        baseline[command] = median;
+    }
+
+    return baseline;
 }
 
+/**
+ * @brief Run a command a number of times, one run at a time.
+ * 
+ * @param args the program name followed by its arguments.
+ * @param runs the number of runs.
+ * @return double the median wall time in seconds.
+ */
+static double medianWallTime(const std::vector<std::string> & args, size_t runs)
+{
+    std::vector<double> times{};
+    for (size_t i = 0; i < std::max(runs, size_t{1}); ++i)
+        times.push_back(spawn(args).usage.wall);
+
+    std::sort(times.begin(), times.end());
+    const size_t middle{times.size() / 2};
+
+    return times.size() % 2 ? times[middle] : (times[middle-1] + times[middle]) / 2;
+}
+
+/**
+ * @brief Time every executed command and compare it with the baseline,
+ * showing the change for each, and record the new times in the baseline if
+ * required.
+ * 
+ * @return true if no command is slower than the tolerance allows.
+ */
+static bool checkBaseline(void)
+{
+    const auto baseline{loadBaseline(baselineFile)};
+
+    std::cout << "\nPerformance against " << baselineFile << " (median of " << gate.runs
+        << " runs, tolerance " << gate.tolerance << "%):\n";
+    std::cout << "  " << std::setw(10) << "baseline" << std::setw(10) << "current" << std::setw(9) << "delta" << "  command\n";
+
+    bool passed{true};
+    std::map<std::string, double> medians{};
+    for (const auto & command : commands)
+    {
+        if (medians.contains(command.line))
+            continue;
+
+        const double median{medianWallTime(command.args, gate.runs)};
+        medians[command.line] = median;
+
+        std::cout << std::fixed << std::setprecision(1);
+        const auto it{baseline.find(command.line)};
+        if ((it == baseline.end()) || (it->second <= 0.0))
+        {
+            std::cout << "  " << std::setw(10) << "-" << std::setw(8) << median * 1e3 << "ms" << std::setw(9) << "new";
+            std::cout << "  " << command.line << '\n';
+            continue;
+        }
+
+        const double delta{(median - it->second) * 100 / it->second};
+        const bool slower{delta > gate.tolerance};
+        passed = passed && !slower;
+        std::cout << "  " << std::setw(8) << it->second * 1e3 << "ms" << std::setw(8) << median * 1e3 << "ms"
+            << std::setw(8) << std::showpos << delta << std::noshowpos << "%  " << command.line
+            << (slower ? "  SLOWER" : "") << '\n';
+    }
+    std::cout.unsetf(std::ios::floatfield);
+
+    if (gate.record)
+    {
+        // Merge into the existing baseline, keeping commands not run this time.
+        auto merged{baseline};
+        for (const auto & [command, median] : medians)
+            merged[command] = median;
+
+        std::ofstream os{baselineFile};
+        os << "command,median\n";
+        for (const auto & [command, median] : merged)
+            os << quoteCsv(command) << ',' << median << '\n';
+        std::cout << "Baseline recorded in " << baselineFile << '\n';
+    }
+
+    return passed || !gate.strict;
+}
 
 
 /**
@@ -213,9 +656,10 @@ Album loadTracks(const std::string & inputFile)
  *
  */
 
-UNIT_TEST(test0, "Test environment'.")
+UNIT_TEST(test0, "Test environment, the Balancer program can be spawned and run.")
 
-    REQUIRE(system(NULL) != 0)
+    const Result result{spawn(buildArguments("-b 1", "TestTimeFormats.txt"))};
+    REQUIRE(WIFEXITED(result.status) && (WEXITSTATUS(result.status) == 0))
 
 END_TEST
 
@@ -227,7 +671,7 @@ END_TEST
 
 UNIT_TEST(testtime1, "Test input with a variety of time formats generating 'plain' output.")
 
-    REQUIRE(executeCommand("-b 1 -p", "TestTimeFormats.txt", "testtime1.txt") == 0)
+    REQUIRE(executeCommand("testtime1.txt") == 0)
 
     REQUIRE(compareAlbums("testtime1.txt"))
 
@@ -235,7 +679,7 @@ END_TEST
 
 UNIT_TEST(testtime2, "Test input with a variety of time formats generating 'hh:mm:ss' output.")
 
-    REQUIRE(executeCommand("-b 1", "TestTimeFormats.txt", "testtime2.txt") == 0)
+    REQUIRE(executeCommand("testtime2.txt") == 0)
 
     REQUIRE(compareAlbums("testtime2.txt"))
 
@@ -243,7 +687,7 @@ END_TEST
 
 UNIT_TEST(testtime3, "Test input with a variety of time formats generating 'shuffled' output.")
 
-    REQUIRE(executeCommand("-b 1 -s", "TestTimeFormats.txt", "testtime3.txt") == 0)
+    REQUIRE(executeCommand("testtime3.txt") == 0)
 
     REQUIRE(compareAlbums("testtime3.txt"))
 
@@ -251,7 +695,7 @@ END_TEST
 
 UNIT_TEST(testtime4, "Test input with a variety of time formats generating 'CSV' output.")
 
-    REQUIRE(executeCommand("-b 1 -c -a '|'", "TestTimeFormats.txt", "testtime4.txt") == 0)
+    REQUIRE(executeCommand("testtime4.txt") == 0)
 
     REQUIRE(compareAlbums("testtime4.txt"))
 
@@ -265,7 +709,7 @@ END_TEST
 
 UNIT_TEST(testoutput11, "Test 'split' output for 4 boxes (plain CSV).")
 
-    REQUIRE(executeCommand("-b 4 -c -a '|' -p", "BeaucoupFish.txt", "split.txt") == 0)
+    REQUIRE(executeCommand("split.txt") == 0)
 
     REQUIRE(compareAlbums("split.txt"))
 
@@ -273,7 +717,7 @@ END_TEST
 
 UNIT_TEST(testoutput12, "Test 'shuffle' output for 4 boxes (plain CSV).")
 
-    REQUIRE(executeCommand("-b 4 -c -a '|' -p -s", "BeaucoupFish.txt", "shuffle.txt") == 0)
+    REQUIRE(executeCommand("shuffle.txt") == 0)
 
     REQUIRE(compareAlbums("shuffle.txt"))
 
@@ -281,7 +725,7 @@ END_TEST
 
 UNIT_TEST(testoutput13, "Test 'brute force' output for 4 boxes (plain CSV).")
 
-    REQUIRE(executeCommand("-b 4 -c -a '|' -p -f", "BeaucoupFish.txt", "force.txt") == 0)
+    REQUIRE(executeCommand("force.txt") == 0)
 
     REQUIRE(compareAlbums("force.txt"))
 
@@ -295,7 +739,7 @@ END_TEST
 
 UNIT_TEST(testoutput21, "Test 'split' output for 22 minute duration (even boxes plain CSV).")
 
-    REQUIRE(executeCommand("-d 22:00 -e -c -a '|' -p", "QueenBest.txt", "split21.txt") == 0)
+    REQUIRE(executeCommand("split21.txt") == 0)
 
     REQUIRE(compareAlbums("split21.txt"))
 
@@ -303,7 +747,7 @@ END_TEST
 
 UNIT_TEST(testoutput22, "Test 'split' output for 12 boxes (plain CSV - same result as above).")
 
-    REQUIRE(executeCommand("-b 12 -c -a '|' -p", "QueenBest.txt", "split22.txt") == 0)
+    REQUIRE(executeCommand("split22.txt") == 0)
 
     REQUIRE(compareAlbums("split22.txt"))
 
@@ -311,7 +755,7 @@ END_TEST
 
 UNIT_TEST(testoutput23, "Test 'shuffle' output for 22 minute duration (even boxes plain CSV).")
 
-    REQUIRE(executeCommand("-d 22:00 -e -c -a '|' -p -s", "QueenBest.txt", "shuffle23.txt") == 0)
+    REQUIRE(executeCommand("shuffle23.txt") == 0)
 
     REQUIRE(compareAlbums("shuffle23.txt"))
 
@@ -325,7 +769,7 @@ END_TEST
 
 UNIT_TEST(testideal11, "Test ideal 'split' output for 4 boxes.")
 
-    REQUIRE(executeCommand("-b 4 -x", "Ideal.txt", "ideal11.txt") == 0)
+    REQUIRE(executeCommand("ideal11.txt") == 0)
 
     REQUIRE(compareAlbums("ideal11.txt"))
 
@@ -333,7 +777,7 @@ END_TEST
 
 UNIT_TEST(testideal12, "Test ideal 'split' output for duration of 20 minutes/side.")
 
-    REQUIRE(executeCommand("-d 20:00 -x", "Ideal.txt", "ideal12.txt") == 0)
+    REQUIRE(executeCommand("ideal12.txt") == 0)
 
     REQUIRE(compareAlbums("ideal12.txt"))
 
@@ -341,7 +785,7 @@ END_TEST
 
 UNIT_TEST(testideal21, "Test ideal 'shuffle' output for 4 boxes.")
 
-    REQUIRE(executeCommand("-b 4 -x -s", "Ideal.txt", "ideal21.txt") == 0)
+    REQUIRE(executeCommand("ideal21.txt") == 0)
 
     REQUIRE(compareAlbums("ideal21.txt"))
 
@@ -349,7 +793,7 @@ END_TEST
 
 UNIT_TEST(testideal22, "Test ideal 'shuffle' output for duration of 20 minutes/side.")
 
-    REQUIRE(executeCommand("-d 20:00 -x -s", "Ideal.txt", "ideal22.txt") == 0)
+    REQUIRE(executeCommand("ideal22.txt") == 0)
 
     REQUIRE(compareAlbums("ideal22.txt"))
 
@@ -357,7 +801,7 @@ END_TEST
 
 UNIT_TEST(testideal31, "Test ideal 'brute force' output for 4 boxes.")
 
-    REQUIRE(executeCommand("-b 4 -x -f", "Ideal.txt", "ideal31.txt") == 0)
+    REQUIRE(executeCommand("ideal31.txt") == 0)
 
     REQUIRE(compareAlbums("ideal31.txt"))
 
@@ -365,13 +809,287 @@ END_TEST
 
 UNIT_TEST(testideal32, "Test ideal 'brute force' output for duration of 20 minutes/side.")
 
-    REQUIRE(executeCommand("-d 20:00 -x -f", "Ideal.txt", "ideal32.txt") == 0)
+    REQUIRE(executeCommand("ideal32.txt") == 0)
 
     REQUIRE(compareAlbums("ideal32.txt"))
 
 END_TEST
 
 
+/**
+ * @section test Side hash maintenance.
+ *
+ */
+
+UNIT_TEST(testside1, "Test the Side hash is order independent and kept up to date by push/pop.")
+
+    const Track a{"a", 150};
+    const Track b{"b", 240};
+    const Track c{"c", 600};
+
+    Side side1{};
+    side1.push(a);
+    side1.push(b);
+    side1.push(c);
+
+    Side side2{};
+    side2.push(c);
+    side2.push(a);
+    side2.push(b);
+    REQUIRE(side1.getHash() == side2.getHash())
+
+    const size_t hash{side1.getHash()};
+    side1.push(a);
+    REQUIRE(side1.getHash() != hash)
+    side1.pop();
+    REQUIRE(side1.getHash() == hash)
+
+    side2.pop();
+    side2.push(Track{"d", 241});
+    REQUIRE(side2.getHash() != hash)
+
+    side1.clear();
+    REQUIRE(side1.getHash() == Side{}.getHash())
+
+END_TEST
+
+
+UNIT_TEST(testside2, "Test the Album hash is kept up to date by push/pop/pushLast.")
+
+    const Track a{"a", 150};
+    const Track b{"b", 240};
+
+    Side side{};
+    side.push(a);
+    side.push(b);
+
+    Album album1{};
+    album1.push(side);
+    album1.push(Side{});
+    album1.pushLast(b);
+
+    Album album2{};
+    album2.push(Side{});
+    album2.pushLast(b);
+    album2.push(Side{});
+    album2.pushLast(b);
+    album2.pushLast(a);
+    REQUIRE(album1.getHash() == album2.getHash())
+
+    const size_t hash{album1.getHash()};
+    album1.push(side);
+    REQUIRE(album1.getHash() != hash)
+    album1.pop();
+    REQUIRE(album1.getHash() == hash)
+
+    album1.clear();
+    REQUIRE(album1.getHash() == Album{}.getHash())
+
+END_TEST
+
+
+UNIT_TEST(testside3, "Test streaming a Side with cached times matches uncached streaming.")
+
+    Side side{};
+    side.setTitle("Side 1");
+    side.push(Track{"a", 150});
+    side.push(Track{"b", 3858});
+
+    Side cached{side};
+    cached.cacheTimes();
+
+    for (const bool plain : {false, true, false})
+        for (const bool csv : {false, true})
+        {
+            std::ostringstream expected{};
+            side.stream(expected, plain, csv);
+            side.summary(expected, plain);
+
+            std::ostringstream actual{};
+            cached.stream(actual, plain, csv);
+            cached.summary(actual, plain);
+            REQUIRE(expected.str() == actual.str())
+        }
+
+    side.push(Track{"c", 61});
+    cached.push(Track{"c", 61});
+
+    std::ostringstream expected{};
+    side.stream(expected);
+    std::ostringstream actual{};
+    cached.stream(actual);
+    REQUIRE(expected.str() == actual.str())
+
+    side.pop();
+    cached.pop();
+    Side copy{cached, std::pmr::new_delete_resource()};
+    for (const Side * other : {&cached, &copy})
+    {
+        std::ostringstream popped{};
+        side.stream(popped, true);
+        std::ostringstream refreshed{};
+        other->stream(refreshed, true);
+        REQUIRE(popped.str() == refreshed.str())
+    }
+
+END_TEST
+
+UNIT_TEST(testwriter1, "Test the buffered Album output goes to the given stream and matches the input.")
+
+    const Album album{loadTracks("ideal11.txt")};
+
+    std::ostringstream os{};
+    REQUIRE(album.stream(os, true, true))
+
+    TextFile<>::Cursor expected{TextFile<>{inputDir + "ideal11.txt"}.cursor()};
+    const std::string text{os.str()};
+    TextFile<>::Cursor actual{text};
+    std::string_view line{};
+    REQUIRE(actual.next(line) && (line == "ideal11.txt:"))
+    for (std::string_view input{}; expected.next(input); )
+    {
+        REQUIRE(actual.next(line))
+        REQUIRE(line.substr(line.find_first_not_of(' ')) == input)
+    }
+    REQUIRE(actual.next(line) && (line == std::to_string(album.getValue())))
+    REQUIRE(!actual.next(line))
+
+    std::ostringstream summary{};
+    REQUIRE(album.summary(summary))
+    REQUIRE(summary.str().starts_with("Side 1 - 2 tracks 00:20:00\n"))
+
+END_TEST
+
+UNIT_TEST(testwriter2, "Test the Writer formats numbers and times and writes to a file descriptor.")
+
+    Writer out{16};
+    out.appendNumber(0).append(' ').appendNumber(18446744073709551615ull).append(' ');
+    out.appendTime(3858, false).append(' ').appendTime(3858, true);
+    REQUIRE(out.view() == "0 18446744073709551615 01:04:18 3858")
+
+    int fds[2];
+    REQUIRE(pipe(fds) == 0)
+    REQUIRE(out.write(fds[1]))
+    close(fds[1]);
+
+    char buffer[64]{};
+    REQUIRE(read(fds[0], buffer, sizeof(buffer)) == static_cast<ssize_t>(out.size()))
+    close(fds[0]);
+    REQUIRE(out.view() == buffer)
+
+END_TEST
+
+UNIT_TEST(testside4, "Test track titles are interned in a pool shared by album copies.")
+
+    Album album{};
+    const Track a{album.makeTrack("Title", 150)};
+    const Track b{album.makeTrack(std::string{"Title"}, 240)};
+    REQUIRE(a.getTitle().data() == b.getTitle().data())
+    REQUIRE(album.getTitles().size() == 1)
+
+    Album copy{album};
+    const Track c{copy.makeTrack("Other", 61)};
+    REQUIRE(album.getTitles().size() == 2)
+    REQUIRE(c.getTitle() == "Other")
+
+    Track d{"Title", 150};
+    d = c;
+    REQUIRE(d.getTitle() == "Other")
+    REQUIRE(d.getValue() == 61)
+    REQUIRE(sizeof(Track) <= 16)
+
+    // An empty title may be the first in a pool.
+    Titles pool{};
+    const Track e{pool, "", 5};
+    REQUIRE(e.getTitle().empty() && (e.getValue() == 5))
+
+    Album empty{};
+    empty.parse("Side|10|\"Side 1, 1 tracks\"\nTrack|10|\"\"\n");
+    REQUIRE((empty.size() == 1) && empty.begin()->begin()->getTitle().empty())
+
+    bool rejected{};
+    try { Track{"Long", size_t{1} << 32}; } catch (const std::out_of_range &) { rejected = true; }
+    REQUIRE(rejected)
+
+END_TEST
+
+UNIT_TEST(testside5, "Test sides and tracks can be moved and emplaced into an album held in an arena.")
+
+    std::array<std::byte, 4096> buffer{};
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+
+    // Any allocation outside the buffer throws.
+    Album album{&arena};
+    album.reserve(3);
+    album.emplace("Side 1");
+    album.pushLast(Track{"a", 150});
+    album.pushLast(Track{"b", 240});
+
+    Side side{};
+    side.setTitle("Side 2");
+    side.emplace("c", 61);
+    side.emplace(album.makeTrack("d", 3858));
+    album.push(side);
+    album.push(std::move(side));
+
+    Album expected{};
+    for (const auto & copy : album)
+        expected.push(copy);
+
+    REQUIRE(album.size() == 3)
+    REQUIRE(album.getValue() == 150 + 240 + 2 * (61 + 3858))
+    REQUIRE(album.getHash() == expected.getHash())
+    REQUIRE(album.getFingerprint() == expected.getFingerprint())
+    REQUIRE(std::next(album.begin())->getTitle() == "Side 2")
+    REQUIRE(std::prev(album.end())->getTitle() == "Side 2")
+
+    Album copy{album};
+    album.clear();
+    REQUIRE((album.size() == 0) && (album.getValue() == 0) && (album.getHash() == Album{}.getHash()))
+    REQUIRE(copy.getHash() == expected.getHash())
+
+END_TEST
+
+
+UNIT_TEST(testside6, "Test an album in an arena with long titles and cached times makes no heap allocations.")
+
+    const std::string_view title{"A side title much longer than any small string buffer"};
+    const Track a{"a", 150};
+    const Track b{"b", 3858};
+    Writer out{4096};
+
+    std::array<std::byte, 8192> buffer{};
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+
+    size_t sides{};
+    const size_t before{heapAllocations};
+    {
+        Album album{&arena};
+        album.setTitle(title);
+        album.reserve(3);
+        album.emplace(title);
+        album.pushLast(a);
+        album.pushLast(b);
+
+        Side side{&arena};
+        side.setTitle(title);
+        side.cacheTimes();
+        side.push(a);
+        side.push(b);
+        side.format(out);
+        album.push(side);
+        album.push(std::move(side));
+
+        album.format(out, true);
+        sides = album.size();
+    }
+    REQUIRE(heapAllocations == before)
+    REQUIRE(sides == 3)
+    REQUIRE(out.view().find(title) != std::string_view::npos)
+
+END_TEST
+
+
 /**
  * @section test Album comparison code.
  *
@@ -422,6 +1140,659 @@ UNIT_TEST(testcompare22, "Compare files with same arrangement of tracks but diff
 
 END_TEST
 
+UNIT_TEST(testcompare31, "Compare files by their canonical 128-bit fingerprints.")
+
+    const Album album{loadTracks("ideal11.txt")};
+    const Fingerprint fingerprint{album.getFingerprint()};
+    REQUIRE(loadTracks("ideal12.txt").getFingerprint() == fingerprint)
+    REQUIRE(loadTracks("ideal13.txt").getFingerprint() == fingerprint)
+    REQUIRE(loadTracks("ideal14.txt").getFingerprint() == fingerprint)
+    REQUIRE(loadTracks("ideal21.txt").getFingerprint() != fingerprint)
+    REQUIRE(loadTracks("ideal22.txt").getFingerprint() != fingerprint)
+
+    // Long sides that differ only by their shortest track.
+    Side side1{};
+    Side side2{};
+    side1.push(Track{"Short", 100});
+    side2.push(Track{"Short", 101});
+    for (size_t i = 0; i < 100; ++i)
+    {
+        side1.push(Track{"Long", 600});
+        side2.push(Track{"Long", 600});
+    }
+    REQUIRE(side1.getFingerprint() != side2.getFingerprint())
+
+    // Every way of dealing 12 tracks across 2 sides is distinct, apart from
+    // swapping the sides.
+    std::vector<Fingerprint> fingerprints{};
+    for (size_t mask = 0; mask < (1u << 11); ++mask)
+    {
+        std::array<Side, 2> sides{};
+        for (size_t i = 0; i < 12; ++i)
+            sides[(mask >> i) & 1].push(Track{"Track", 60u + i});
+
+        Album dealt{};
+        Album swapped{};
+        dealt.push(sides[0]);
+        dealt.push(sides[1]);
+        swapped.push(sides[1]);
+        swapped.push(sides[0]);
+        REQUIRE(dealt.getFingerprint() == swapped.getFingerprint())
+        fingerprints.push_back(dealt.getFingerprint());
+    }
+    std::sort(fingerprints.begin(), fingerprints.end());
+    REQUIRE(std::adjacent_find(fingerprints.begin(), fingerprints.end()) == fingerprints.end())
+
+END_TEST
+
+
+/**
+ * @section test time string parsing.
+ *
+ */
+
+UNIT_TEST(testparse1, "Test parsing H:M:S, M:S and S time strings.")
+
+    REQUIRE(timeStringToSeconds("03:48") == 228)
+    REQUIRE(timeStringToSeconds("2:49") == 169)
+    REQUIRE(timeStringToSeconds("301") == 301)
+    REQUIRE(timeStringToSeconds("1:04:18") == 3858)
+    REQUIRE(timeStringToSeconds("10:05:54") == 36354)
+    REQUIRE(timeStringToSeconds(" 1.02-03 ") == 3723)
+    REQUIRE(timeStringToSeconds("1:02:03:04") == 3723)
+    REQUIRE(timeStringToSeconds("") == 0)
+    REQUIRE(timeStringToSeconds("none") == 0)
+
+    const std::vector<std::string_view> column{"03:48", "2:49", "301", "00:02:52"};
+    std::vector<size_t> seconds(column.size());
+    REQUIRE(timeStringsToSeconds(column, seconds) == column.size())
+    REQUIRE(seconds == std::vector<size_t>({228, 169, 301, 172}))
+
+END_TEST
+
+
+UNIT_TEST(testparse2, "Test parsing a CSV album from a buffer, whole and in pieces.")
+
+    const std::string text{"Side|400|\"Side 1, 2 tracks\"\r\n"
+        "Track|150|\"a\"\n"
+        "Track|4:10|\"b, c\"\n"
+        "\n"
+        "Side|61|\"Side 2, 1 tracks\"\n"
+        "Track|61|\"a\"\n"
+        "Track|99|\"unterminated\""};
+
+    Album whole{};
+    REQUIRE(whole.parse(text) == text.rfind('\n') + 1)
+    REQUIRE(whole.size() == 2)
+    REQUIRE(whole.getValue() == 461)
+    REQUIRE(whole.begin()->getTitle() == "Side 1")
+    REQUIRE((whole.begin()->begin()+1)->getTitle() == "b, c")
+
+    Album expected{};
+    expected.push(Side{});
+    expected.pushLast(Track{"a", 150});
+    expected.pushLast(Track{"b, c", 250});
+    expected.push(Side{});
+    expected.pushLast(Track{"a", 61});
+    REQUIRE(whole.getHash() == expected.getHash())
+
+    // Feed the text a few characters at a time, as a reader would.
+    Album pieces{};
+    std::string pending{};
+    for (size_t i = 0; i < text.size(); i += 7)
+    {
+        pending += text.substr(i, 7);
+        pending.erase(0, pieces.parse(pending));
+    }
+    REQUIRE(pending == "Track|99|\"unterminated\"")
+    REQUIRE(pieces.getHash() == whole.getHash())
+    REQUIRE(pieces.getValue() == whole.getValue())
+
+    Album stopped{};
+    stopped.parse("Side|400|\"Side 1\"\nTrack|150|\"a\"\n");
+    REQUIRE(stopped.size() == 0)
+
+END_TEST
+
+
+UNIT_TEST(testalbumfile1, "Test a binary Album file round trips an album and its CSV.")
+
+    const Album album{loadTracks("ideal11.txt")};
+    const std::string fileName{outputDir + "ideal11.bin"};
+    REQUIRE(writeAlbumFile(album, fileName) == 0)
+
+    AlbumFile file{fileName};
+    REQUIRE(file.map() == 0)
+    REQUIRE(file.getTitle() == "ideal11.txt")
+    REQUIRE(file.size() == album.size())
+    REQUIRE(file.getValue() == album.getValue())
+    REQUIRE(file.getTrackTitle(0) == "Track 1 1")
+    REQUIRE(file.getDurations()[0] == 780)
+
+    const Album loaded{file.load()};
+    REQUIRE(loaded.getHash() == album.getHash())
+    REQUIRE(loaded.begin()->getTitle() == "Side 1")
+
+    Writer csv{};
+    file.formatCsv(csv);
+    TextFile<>::Cursor expected{TextFile<>{inputDir + "ideal11.txt"}.cursor()};
+    TextFile<>::Cursor actual{csv.view()};
+    REQUIRE(!expected.compare(actual).found)
+
+    AlbumFile text{inputDir + "ideal11.txt"};
+    REQUIRE(text.map() != 0)
+    REQUIRE(!text.isOpen())
+
+    // A title outside the title text is rejected.
+    std::string bytes{};
+    if (std::ifstream is{fileName, std::ios::binary})
+        bytes.assign(std::istreambuf_iterator<char>{is}, {});
+    AlbumHeader header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    const size_t entry{sizeof(AlbumHeader) + header.sides * sizeof(SideEntry) + header.tracks * sizeof(uint32_t)};
+    const TitleEntry corrupt{static_cast<uint32_t>(header.strings), 1};
+    std::memcpy(bytes.data() + entry, &corrupt, sizeof(corrupt));
+    if (std::ofstream os{outputDir + "corrupt.bin", std::ios::binary})
+        os << bytes;
+    AlbumFile bad{outputDir + "corrupt.bin"};
+    REQUIRE(bad.map() != 0)
+
+    // Table sizes that only match the file size once the total wraps.
+    AlbumHeader huge{header};
+    huge.tracks += 0x10000000;
+    huge.strings -= size_t{0x10000000} * (sizeof(uint32_t) + sizeof(TitleEntry));
+    bytes.replace(0, sizeof(huge), reinterpret_cast<const char *>(&huge), sizeof(huge));
+    if (std::ofstream os{outputDir + "wrapped.bin", std::ios::binary})
+        os << bytes;
+    AlbumFile wrapped{outputDir + "wrapped.bin"};
+    REQUIRE(wrapped.map() != 0)
+
+END_TEST
+
+
+UNIT_TEST(testgenerate1, "Test seeded track generation is repeatable and within the requested range.")
+
+    Spec spec{};
+    spec.count = 1000;
+    spec.seed = 42;
+    spec.minimum = 120;
+    spec.maximum = 480;
+
+    for (const auto distribution : {Distribution::uniform, Distribution::normal, Distribution::exponential})
+    {
+        spec.distribution = distribution;
+        const auto tracks{generateTracks(spec)};
+        REQUIRE(tracks.size() == spec.count)
+
+        const auto again{generateTracks(spec)};
+        REQUIRE(std::equal(tracks.begin(), tracks.end(), again.begin(),
+            [](const Track & a, const Track & b) { return (a.getValue() == b.getValue()) && (a.getTitle() == b.getTitle()); }))
+
+        auto shorter{[](const Track & a, const Track & b) { return a.getValue() < b.getValue(); }};
+        const auto [low, high]{std::minmax_element(tracks.begin(), tracks.end(), shorter)};
+        REQUIRE((low->getValue() >= spec.minimum) && (high->getValue() <= spec.maximum))
+        REQUIRE(low->getValue() != high->getValue())
+    }
+
+    spec.distribution = Distribution::uniform;
+    const auto first{generateTracks(spec)};
+    ++spec.seed;
+    const auto second{generateTracks(spec)};
+    REQUIRE(!std::equal(first.begin(), first.end(), second.begin(),
+        [](const Track & a, const Track & b) { return a.getValue() == b.getValue(); }))
+
+    Writer out{};
+    formatInput(out, std::vector<Track>{first.begin(), first.begin() + 2});
+    REQUIRE(out.view() == secondsToTimeString(first[0].getValue()) + "\tTrack 1\n" + secondsToTimeString(first[1].getValue()) + "\tTrack 2\n")
+
+    Distribution distribution{};
+    REQUIRE(parseDistribution("exponential", distribution) && (distribution == Distribution::exponential))
+    REQUIRE(!parseDistribution("poisson", distribution))
+
+END_TEST
+
+
+UNIT_TEST(testprocess1, "Test spawning a child captures its output and resource usage.")
+
+    const Result result{spawn(splitArguments("sh -c 'echo \"hello  world\"'"))};
+    REQUIRE(result.status == 0)
+    REQUIRE(result.output == "hello  world\n")
+    REQUIRE(result.usage.wall > 0.0)
+    REQUIRE(result.usage.maxRss > 0)
+    REQUIRE(result.usage.minorFaults > 0)
+
+    REQUIRE(spawn({"no-such-program-for-balancer-tests"}).status != 0)
+
+    const Result slow{spawn({"sleep", "10"}, 0.2)};
+    REQUIRE(slow.timedOut)
+    REQUIRE(WIFSIGNALED(slow.status) && (WTERMSIG(slow.status) == SIGKILL))
+    REQUIRE(slow.usage.wall < 5.0)
+    REQUIRE(!result.timedOut)
+
+    const Result closed{spawn({"sh", "-c", "exec >&-; sleep 10"}, 0.2)};
+    REQUIRE(closed.timedOut)
+    REQUIRE(closed.usage.wall < 5.0)
+
+    const Result quick{spawn({"sh", "-c", "exec >&-; sleep 0.1"}, 5.0)};
+    REQUIRE(!quick.timedOut && (quick.status == 0))
+
+END_TEST
+
+
+UNIT_TEST(testformat1, "Test formatting seconds as H:M:S time strings.")
+
+    TimeBuffer buffer;
+    REQUIRE(secondsToTimeString(0, buffer) == "00:00:00")
+    REQUIRE(secondsToTimeString(3858, buffer) == "01:04:18")
+    REQUIRE(secondsToTimeString(36354, buffer, '.') == "10.05.54")
+    REQUIRE(secondsToTimeString(360059, buffer) == "100:00:59")
+    REQUIRE(secondsToString(41082, buffer, true) == "41082")
+    REQUIRE(secondsToString(41082, buffer, false) == "11:24:42")
+
+    REQUIRE(secondsToTimeString(3858) == "01:04:18")
+    REQUIRE(secondsToTimeString(3858, " - ") == "01 - 04 - 18")
+
+END_TEST
+
+
+UNIT_TEST(testsplit1, "Test splitting lines into views, removing quotes.")
+
+    std::array<std::string_view, 3> tokens{};
+
+    REQUIRE(split("Track|780|\"Track 1 1\"", tokens) == 3)
+    REQUIRE(tokens[0] == "Track")
+    REQUIRE(tokens[1] == "780")
+    REQUIRE(tokens[2] == "Track 1 1")
+
+    REQUIRE(split("Side|1200|\"Side 1, 2 tracks\"", tokens) == 3)
+    REQUIRE(tokens[2] == "Side 1, 2 tracks")
+
+    REQUIRE(split("\"A|B\"|2|x|y", tokens) == 3)
+    REQUIRE(tokens[0] == "A|B")
+    REQUIRE(tokens[2] == "x|y")
+
+    std::array<std::string_view, 2> pair{};
+    REQUIRE(split("Track|\"Say \"Hi\"\"", pair) == 2)
+    REQUIRE(pair[1] == "Say \"Hi\"")
+
+    REQUIRE(split("", tokens) == 1)
+    REQUIRE(tokens[0].empty())
+
+END_TEST
+
+
+/**
+ * @section test TextFile reading.
+ *
+ */
+
+UNIT_TEST(testtextfile1, "Test memory mapped reading matches stream reading.")
+
+    REQUIRE(compareMapped(inputDir + "TestTimeFormats.txt"))
+    REQUIRE(compareMapped(inputDir + "ideal11.txt"))
+    REQUIRE(compareMapped(expectedDir + "ideal11.txt"))
+    REQUIRE(compareMapped(expectedDir + "force.txt"))
+
+END_TEST
+
+UNIT_TEST(testtextfile2, "Test TextFile line storage and random access.")
+
+    const std::vector<std::string> data{"Side|1200|\"Side 1, 2 tracks\"", "Track|780|\"Track 1 1\"", "Track|420|\"Track 1 2\""};
+
+    TextFile<> file{inputDir + "ideal11.txt"};
+    file.read();
+    TextFile<> lines{outputDir + "lines.txt"};
+    lines.setData(data);
+
+    REQUIRE(lines.size() == 3)
+    REQUIRE(lines[1] == data[1])
+    REQUIRE(file[2] == lines[2])
+    REQUIRE(file.equal(lines, 3))
+    REQUIRE(!file.equal(lines))
+    REQUIRE(!lines.equal(file, 4))
+
+    TextFile<> copy{lines};
+    lines.clear();
+    REQUIRE(copy.getData().back() == data.back())
+
+END_TEST
+
+UNIT_TEST(testtextfile3, "Test the streaming cursor matches reading, even with a tiny buffer.")
+
+    for (const auto & fileName : {inputDir + "TestTimeFormats.txt", expectedDir + "force.txt"})
+    {
+        TextFile<> file{fileName};
+        file.read();
+
+        TextFile<> streamed{fileName};
+        auto cursor{file.cursor(4)};
+        for (std::string_view line{}; cursor.next(line); )
+            streamed.push_back(line);
+
+        REQUIRE(cursor.isOpen())
+        REQUIRE(file.equal(streamed))
+    }
+
+    TextFile<>::Cursor text{"a\r\n\nb\nc"};
+    std::string_view line{};
+    REQUIRE(text.next(line) && (line == "a"))
+    REQUIRE(text.next(line) && (line == "b"))
+    REQUIRE(!text.next(line))
+    REQUIRE(text.getLineNumber() == 3)
+
+    REQUIRE(!TextFile<>{inputDir + "Missing.txt"}.cursor().isOpen())
+
+END_TEST
+
+UNIT_TEST(testtextfile4, "Test the streaming comparison finds the first difference.")
+
+    TextFile<>::Cursor same1{"a\r\nb\n\nc\n"};
+    TextFile<>::Cursor same2{"a\nb\nc\n"};
+    REQUIRE(!same1.compare(same2).found)
+
+    TextFile<>::Cursor expected{"a\nb\nc\nd\n"};
+    TextFile<>::Cursor actual{"a\nb\nx\nd\n"};
+    const auto difference{expected.compare(actual)};
+    REQUIRE(difference.found)
+    REQUIRE(difference.expectedLine == 3)
+    REQUIRE(difference.actualLine == 3)
+    REQUIRE(difference.expected == "c")
+    REQUIRE(difference.actual == "x")
+
+    TextFile<>::Cursor longer{"a\nb\n"};
+    TextFile<>::Cursor shorter{"a\n"};
+    const auto missing{longer.compare(shorter)};
+    REQUIRE(missing.found)
+    REQUIRE(missing.expectedLine == 2)
+    REQUIRE(missing.actualLine == 0)
+
+    auto file{TextFile<>{expectedDir + "force.txt"}.cursor(16)};
+    auto copy{TextFile<>{expectedDir + "force.txt"}.cursor()};
+    REQUIRE(!file.compare(copy).found)
+
+END_TEST
+
+UNIT_TEST(testtextfile5, "Test the line terminator scan at every offset and for wide characters.")
+
+    // A terminator at each position, either side of the 16 and 32 byte blocks.
+    auto terminator{[](char c) { return (c == '\r') || (c == '\n') || (c == '\0'); }};
+    for (const char c : {'\r', '\n', '\0'})
+        for (size_t length = 0; length <= 80; ++length)
+            for (size_t pos = 0; pos <= length; ++pos)
+            {
+                std::string text(length, 'x');
+                if (pos < length)
+                    text[pos] = c;
+                const char * first{text.data()};
+                const char * last{first + text.size()};
+                REQUIRE(findTerminator(first, last) == std::find_if(first, last, terminator))
+            }
+
+    std::string text{};
+    std::vector<std::string> expected{};
+    for (size_t length = 1; length <= 70; ++length)
+    {
+        const std::string line(length, char('a' + length % 26));
+        expected.push_back(line);
+        text += line + ((length % 3) ? "\n" : "\r\n") + ((length % 5) ? "" : "\n");
+        if (length % 7 == 0)
+        {
+            text += std::string{"x\0y\n", 4};
+            expected.push_back("x");
+        }
+    }
+    text += "partial";
+
+    TextFile<> file{outputDir + "lines.txt"};
+    if (std::ofstream os{outputDir + "lines.txt", std::ios::binary})
+        os << text;
+    REQUIRE(file.read() == 0)
+    REQUIRE(std::equal(file.begin(), file.end(), expected.begin(), expected.end()))
+
+    TextFile<> mapped{outputDir + "lines.txt"};
+    REQUIRE(mapped.map() == 0)
+    REQUIRE(mapped.equal(file))
+
+    TextFile<>::Cursor cursor{text};
+    size_t count{};
+    for (std::string_view line{}; cursor.next(line); ++count)
+        REQUIRE(line == expected[count])
+    REQUIRE(count == expected.size())
+
+    REQUIRE(TextFile<wchar_t>::trim(L"wide\rline") == L"wide")
+    const wchar_t wideText[]{L"one\r\n\ntwo\0x\nthree"};
+    TextFile<wchar_t>::Cursor wide{std::wstring_view{wideText, std::size(wideText) - 1}};
+    std::wstring_view line{};
+    REQUIRE(wide.next(line) && (line == L"one"))
+    REQUIRE(wide.next(line) && (line == L"two"))
+    REQUIRE(!wide.next(line))
+
+END_TEST
+
+
+/**
+ * @section test the in-process balancing engine.
+ *
+ */
+
+UNIT_TEST(testengine11, "Test in-process ideal 'split' for 4 boxes matches the expected sides.")
+
+    const Config config{.boxes=4, .ideal=true};
+    Album album{balance(loadInput("Ideal.txt"), config)};
+    Album expected{loadTracks("ideal11.txt")};
+
+    REQUIRE(album.size() == 4)
+    REQUIRE(album.getValue() == expected.getValue())
+    REQUIRE(album.getHash() == expected.getHash())
+
+END_TEST
+
+UNIT_TEST(testengine12, "Test in-process ideal 'split' for duration of 20 minutes/side.")
+
+    const Config config{.duration=20*60, .ideal=true};
+    Album album{balance(loadInput("Ideal.txt"), config)};
+    Album expected{loadTracks("ideal11.txt")};
+
+    REQUIRE(album.size() == 4)
+    REQUIRE(album.getHash() == expected.getHash())
+
+END_TEST
+
+UNIT_TEST(testengine13, "Test in-process 'brute force' for 4 boxes.")
+
+    const Config config{.boxes=4, .force=true};
+    Album album{balance(loadInput("Ideal.txt"), config)};
+    Album expected{loadTracks("ideal11.txt")};
+
+    REQUIRE(album.size() == 4)
+    REQUIRE(album.getHash() == expected.getHash())
+
+END_TEST
+
+UNIT_TEST(testengine21, "Test in-process 'split' for 4 boxes matches the Balancer sides.")
+
+    const Config config{.boxes=4};
+    Album album{balance(loadInput("BeaucoupFish.txt"), config)};
+    Album expected{loadTracks("split.txt", expectedDir)};
+
+    REQUIRE(album.size() == 4)
+    REQUIRE(album.getValue() == expected.getValue())
+    REQUIRE(album.getHash() == expected.getHash())
+
+END_TEST
+
+UNIT_TEST(testengine22, "Test in-process 'shuffle' for even boxes of 22 minute duration.")
+
+    const Config config{.duration=22*60, .even=true, .shuffle=true};
+    const auto tracks{loadInput("QueenBest.txt")};
+    Album album{balance(tracks, config)};
+
+    size_t count{};
+    size_t longest{};
+    for (const auto & side : album)
+    {
+        count += side.size();
+        longest = std::max(longest, side.getValue());
+    }
+
+    REQUIRE(album.size() == 10)
+    REQUIRE(count == tracks.size())
+    REQUIRE(longest <= 22*60)
+
+END_TEST
+
+UNIT_TEST(testengine23, "Test the balancing functions use at least one side.")
+
+    const auto tracks{loadInput("Ideal.txt")};
+    for (const auto & album : {splitTracks(tracks, 0), splitTracks(tracks, 0, true), shuffleTracks(tracks, 0), bruteForce(tracks, 0)})
+    {
+        REQUIRE(album.size() == 1)
+        REQUIRE(album.begin()->size() == tracks.size())
+    }
+
+    REQUIRE(bruteForce({}, 0).size() == 1)
+
+END_TEST
+
+
+/**
+ * @section test the optimality oracle.
+ *
+ */
+
+UNIT_TEST(testoracle1, "Test the optimality oracle against known partitions.")
+
+    const std::vector<size_t> durations{5, 4, 3, 3, 2};
+    const size_t expected[]{17, 9, 6, 5, 5, 5};
+    for (size_t sides = 1; sides <= 6; ++sides)
+        REQUIRE(optimalLongestSide(durations, sides) == expected[sides-1])
+
+    REQUIRE(optimalLongestSide(std::vector<size_t>{}, 3) == 0)
+    REQUIRE(optimalLongestSide(std::vector<size_t>{7, 7, 7, 7, 7, 7}, 4) == 14)
+    REQUIRE(optimalLongestSide(std::vector<size_t>{8, 7, 6, 5, 4}, 2) == 15)
+    REQUIRE(optimalLongestSide(std::vector<size_t>{10, 9, 8, 7, 6, 5, 4, 3, 2, 1}, 5) == 11)
+
+    // The lower bound of 25 can't be met, a search that runs out of budget
+    // proving it gives no answer.
+    const std::vector<size_t> hard{20, 18, 16, 9, 8, 1};
+    REQUIRE(optimalLongestSide(hard, 3) == 26)
+    REQUIRE(!optimalLongestSide(hard, 3, 2))
+
+    // Brute force finds the optimum on small inputs.
+    Spec spec{};
+    spec.count = 9;
+    for (spec.seed = 1; spec.seed <= 4; ++spec.seed)
+    {
+        const auto tracks{generateTracks(spec)};
+        for (size_t sides = 2; sides <= 4; ++sides)
+            REQUIRE(isOptimal(bruteForce(tracks, sides)))
+    }
+
+END_TEST
+
+UNIT_TEST(testoracle2, "Test the optimality oracle checks Balancer results and scales to large inputs.")
+
+    REQUIRE(isOptimal(balance(loadInput("Ideal.txt"), Config{.boxes=4, .force=true})))
+    REQUIRE(isOptimal(loadTracks("ideal11.txt")))
+    REQUIRE(!isOptimal(loadTracks("split.txt", expectedDir)))
+    REQUIRE(optimalLongestSide(loadTracks("split.txt", expectedDir)) == 2903)
+
+    Spec spec{};
+    spec.count = 10000;
+    const auto tracks{generateTracks(spec)};
+    std::vector<size_t> durations{};
+    size_t total{};
+    for (const auto & track : tracks)
+    {
+        durations.push_back(track.getValue());
+        total += track.getValue();
+    }
+
+    for (const size_t sides : {2, 3, 4, 8})
+    {
+        const auto optimal{optimalLongestSide(durations, sides)};
+        size_t longest{};
+        for (const auto & side : balance(tracks, Config{.boxes=sides, .shuffle=true}))
+            longest = std::max(longest, side.getValue());
+
+        REQUIRE(optimal.has_value())
+        REQUIRE(*optimal >= (total + sides - 1) / sides)
+        REQUIRE(*optimal <= longest)
+    }
+
+END_TEST
+
+
+/**
+ * @section test the result validator.
+ *
+ */
+
+UNIT_TEST(testvalidate1, "Test the validator accepts any arrangement of the input tracks and nothing else.")
+
+    Spec spec{};
+    spec.count = 10000;
+    const auto tracks{generateTracks(spec)};
+    for (const auto & config : {Config{.boxes=8}, Config{.boxes=8, .shuffle=true}, Config{.duration=3600, .ideal=true}})
+        REQUIRE(isPermutation(tracks, balance(tracks, config)))
+
+    const std::vector<Track> input{{"One", 100}, {"Two", 200}, {"Two", 200}, {"Three", 300}};
+    auto build{[](const std::vector<Track> & first, const std::vector<Track> & second)
+    {
+        Album album{};
+        for (const auto & tracks : {first, second})
+        {
+            album.push(Side{});
+            for (const auto & track : tracks)
+                album.pushLast(track);
+        }
+
+        return album;
+    }};
+
+    REQUIRE(isPermutation(input, build({{"Two", 200}, {"Three", 300}}, {{"Two", 200}, {"One", 100}})))
+    REQUIRE(!isPermutation(input, build({{"Two", 200}, {"Three", 300}}, {{"Two", 200}})))
+    REQUIRE(!isPermutation(input, build({{"Two", 200}, {"Three", 300}}, {{"Two", 200}, {"One", 100}, {"One", 100}})))
+    REQUIRE(!isPermutation(input, build({{"Two", 200}, {"Three", 300}}, {{"One", 100}, {"One", 100}})))
+    REQUIRE(!isPermutation(input, build({{"Two", 200}, {"Three", 300}}, {{"Two", 201}, {"One", 100}})))
+    REQUIRE(!isPermutation(input, build({{"Two", 200}, {"Four", 300}}, {{"Two", 200}, {"One", 100}})))
+
+END_TEST
+
+UNIT_TEST(testvalidate2, "Test the balance quality of the expected Balancer output.")
+
+    const auto tracks{loadInput("BeaucoupFish.txt")};
+    for (const auto fileName : {"split.txt", "shuffle.txt", "force.txt"})
+        REQUIRE(isPermutation(tracks, loadTracks(fileName, expectedDir)))
+    REQUIRE(!isPermutation(tracks, loadTracks("split21.txt", expectedDir)))
+
+    const Quality split{measureQuality(loadTracks("split.txt", expectedDir))};
+    const Quality shuffle{measureQuality(loadTracks("shuffle.txt", expectedDir))};
+    REQUIRE(split.longest == 3194)
+    REQUIRE(split.spread == split.longest - split.shortest)
+    REQUIRE(shuffle.ideal == split.ideal)
+    REQUIRE(shuffle.spread < split.spread)
+    REQUIRE(shuffle.variance < split.variance)
+
+    const Quality ideal{measureQuality(loadTracks("ideal11.txt"))};
+    REQUIRE((ideal.longest == 1200) && (ideal.shortest == 1200))
+    REQUIRE((ideal.spread == 0) && (ideal.variance == 0.0))
+    REQUIRE(measureQuality(Album{}).longest == 0)
+
+END_TEST
+
+
+/**
+ * @section check performance against the baseline, after the other tests.
+ *
+ */
+
+UNIT_TEST(testbaseline, "Test no Balancer command is slower than the baseline allows.")
+
+    REQUIRE(checkBaseline())
+
+END_TEST
+
 
 int runTests(const char * program, const bool testAll)
 {
@@ -434,6 +1805,9 @@ int runTests(const char * program, const bool testAll)
 
     RUN_TEST(test0)
 
+    queueCommands(testAll);
+    startWorkers();
+
     RUN_TEST(testtime1)
     RUN_TEST(testtime2)
     RUN_TEST(testtime3)
@@ -453,18 +1827,58 @@ int runTests(const char * program, const bool testAll)
     if (testAll) RUN_TEST(testideal31)
     if (testAll) RUN_TEST(testideal32)
 
+    RUN_TEST(testside1)
+    RUN_TEST(testside2)
+    RUN_TEST(testside3)
+    RUN_TEST(testside4)
+    RUN_TEST(testside5)
+    RUN_TEST(testside6)
+    RUN_TEST(testwriter1)
+    RUN_TEST(testwriter2)
+
     RUN_TEST(testcompare12)
     RUN_TEST(testcompare13)
     RUN_TEST(testcompare14)
     RUN_TEST(testcompare21)
     RUN_TEST(testcompare22)
-
+    RUN_TEST(testcompare31)
+
+    RUN_TEST(testparse1)
+    RUN_TEST(testparse2)
+    RUN_TEST(testalbumfile1)
+    RUN_TEST(testgenerate1)
+    RUN_TEST(testprocess1)
+    RUN_TEST(testformat1)
+    RUN_TEST(testsplit1)
+
+    RUN_TEST(testtextfile1)
+    RUN_TEST(testtextfile2)
+    RUN_TEST(testtextfile3)
+    RUN_TEST(testtextfile4)
+    RUN_TEST(testtextfile5)
+
+    RUN_TEST(testengine11)
+    RUN_TEST(testengine12)
+    RUN_TEST(testengine13)
+    RUN_TEST(testengine21)
+    RUN_TEST(testengine22)
+    RUN_TEST(testengine23)
+    RUN_TEST(testoracle1)
+    RUN_TEST(testoracle2)
+    RUN_TEST(testvalidate1)
+    RUN_TEST(testvalidate2)
+
+    stopWorkers();
+
+    if (gate.record || std::filesystem::exists(baselineFile))
+        RUN_TEST(testbaseline)
 
     const auto err{FINISHED};
     if (!err)
     {
         std::cout << "\nCommands executed:\n";
         displayCommands();
+        writeUsageReport(outputDir + "usage");
         // genTestScript("runTests.sh", program);
     }
     OUTPUT_SUMMARY;
@@ -472,9 +1886,53 @@ int runTests(const char * program, const bool testAll)
     return err;
 }
 
+/**
+ * @brief Parse the command line into the performance gate settings.
+ * 
+ * @param argc command line argument count.
+ * @param argv command line argument vector.
+ * @param testAll set if all of the tests should be run.
+ * @return true if the options are valid.
+ */
+static bool parseOptions(int argc, char *argv[], bool & testAll)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        if (arg == "-r")
+            gate.record = true;
+        else if (arg == "-s")
+            gate.strict = true;
+        else if (arg == "-c")
+        {
+            if ((i+1 == argc) || !parseValue(argv[++i], gate.runs) || (gate.runs == 0))
+                return false;
+        }
+        else if (arg == "-t")
+        {
+            if ((i+1 == argc) || !parseValue(argv[++i], gate.tolerance) || (gate.tolerance < 0.0))
+                return false;
+        }
+        else
+            testAll = true;
+    }
+
+    return true;
+}
+
 /**
  * Test system entry point.
  *
+ * Options:
+ *    -r      record the command times in testdata/baseline.csv, keeping the
+ *            times of any commands not run.
+ *    -c N    time each command N times and use the median (default 5).
+ *    -t P    warn if a command is more than P% slower than the baseline
+ *            (default 25).
+ *    -s      fail, rather than warn, if a command is too slow.
+ *
+ * Any other argument runs all of the tests.
+ *
  * @param  argc - command line argument count.
  * @param  argv - command line argument vector.
  * @return error value or 0 if no errors.
@@ -482,9 +1940,13 @@ int runTests(const char * program, const bool testAll)
 
 int main(int argc, char *argv[])
 {
-    const bool testAll{argc > 1};
+    bool testAll{};
+    if (!parseOptions(argc, argv, testAll))
+    {
+        std::cerr << "Usage: " << argv[0] << " [-r] [-c runs] [-t percent] [-s] [all]\n";
+        return 1;
+    }
     createDirectory(outputDir);
 
     return runTests(argv[0], testAll);
 }
-